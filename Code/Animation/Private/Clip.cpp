@@ -1,6 +1,118 @@
 #include "Animation/Public/Clip.h"
+#include "Animation/Public/TrackHelpers.h"
 
-Clip::Clip()
+template TClip<TransformTrack>;
+template TClip<CompressedTransformTrack>;
+
+namespace ClipHelpers
+{
+    // Index of the timeline with exactly the track's key times, added if there is none yet
+    template <typename TRACK>
+    int FindOrAddTimeline(std::vector<Timeline>& timelines, TRACK& track)
+    {
+        const unsigned int size = track.Size();
+        if (size <= 1)
+        {
+            return -1;
+        }
+
+        const unsigned int numTimelines = static_cast<unsigned>(timelines.size());
+        for (unsigned int i = 0; i < numTimelines; ++i)
+        {
+            const Timeline& timeline = timelines[i];
+            if (timeline.Size() != size)
+            {
+                continue;
+            }
+            unsigned int frame = 0;
+            while (frame < size && timeline[frame] == track.GetTime(frame))
+            {
+                ++frame;
+            }
+            if (frame == size)
+            {
+                return static_cast<int>(i);
+            }
+        }
+
+        timelines.emplace_back();
+        Timeline& timeline = timelines[numTimelines];
+        timeline.Resize(size);
+        for (unsigned int frame = 0; frame < size; ++frame)
+        {
+            timeline[frame] = track.GetTime(frame);
+        }
+        return static_cast<int>(numTimelines);
+    }
+
+    // Collapses the track to its first key if every key holds the same value.
+    // Cubic tracks also need flat tangents, or they still move between equal keys.
+    template <typename T, int N>
+    bool CollapseConstantTrack(Track<T, N>& track)
+    {
+        const unsigned int size = track.Size();
+        if (size <= 1)
+        {
+            return false;
+        }
+        const bool cubic = track.GetInterpolation() == Interpolation::Cubic;
+        T first = TrackHelpers::Cast<T>(track[0].mValue);
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            if (TrackHelpers::Difference(first, TrackHelpers::Cast<T>(track[i].mValue)) > CLIP_CONSTANT_EPSILON)
+            {
+                return false;
+            }
+            for (int c = 0; cubic && c < N; ++c)
+            {
+                if (fabsf(track[i].mIn[c]) > CLIP_CONSTANT_EPSILON || fabsf(track[i].mOut[c]) > CLIP_CONSTANT_EPSILON)
+                {
+                    return false;
+                }
+            }
+        }
+        track.Resize(1);
+        return true;
+    }
+
+    // Empties a single key track that holds the value the pose already has
+    template <typename T, int N>
+    bool RemoveRestTrack(Track<T, N>& track, const T& rest)
+    {
+        if (track.Size() != 1 ||
+            TrackHelpers::Difference(rest, TrackHelpers::Cast<T>(track[0].mValue)) > CLIP_CONSTANT_EPSILON)
+        {
+            return false;
+        }
+        track.Resize(0);
+        return true;
+    }
+
+    // Resolves only the timelines one transform track uses, into storage the caller owns.
+    // outLocal indexes outSamples the way the clip's table indexes its shared samples.
+    inline void ResolveTrackTimelines(const std::vector<Timeline>& timelines, const TransformTimelines& trackTimelines,
+                                      float time, bool looping, TimelineSample* outSamples, TransformTimelines& outLocal)
+    {
+        if (trackTimelines.mPosition >= 0)
+        {
+            outSamples[0] = timelines[trackTimelines.mPosition].Resolve(time, looping);
+            outLocal.mPosition = 0;
+        }
+        if (trackTimelines.mRotation >= 0)
+        {
+            outSamples[1] = timelines[trackTimelines.mRotation].Resolve(time, looping);
+            outLocal.mRotation = 1;
+        }
+        if (trackTimelines.mScale >= 0)
+        {
+            outSamples[2] = timelines[trackTimelines.mScale].Resolve(time, looping);
+            outLocal.mScale = 2;
+        }
+    }
+} // End of ClipHelpers
+
+template <typename TRACK>
+TClip<TRACK>::TClip()
 {
     mName = "None";
     mStartTime = 0.0f;
@@ -8,7 +120,9 @@ Clip::Clip()
     mLooping = true;
 }
 
-float Clip::Sample(Pose& outPose, float time)
+template <typename TRACK>
+template <typename POSE>
+float TClip<TRACK>::SampleInto(POSE& outPose, float time)
 {
     if (GetDuration() == 0.0f)
     {
@@ -17,6 +131,22 @@ float Clip::Sample(Pose& outPose, float time)
     time = AdjustTimeToFitRange(time);
 
     unsigned int size = mTracks.size();
+    if (HasTimelines())
+    {
+        // With nowhere to keep shared segments, each track resolves its own timelines on the
+        // stack, so a clip can be sampled from several threads. A cursor resolves each one once.
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            TimelineSample samples[3];
+            TransformTimelines local;
+            ClipHelpers::ResolveTrackTimelines(mTimelines, mTrackTimelines[i], time, mLooping, samples, local);
+            unsigned int joint = mTracks[i].GetId();
+            Transform pose = outPose.GetLocalTransform(joint);
+            Transform animated = mTracks[i].Sample(pose, samples, local);
+            outPose.SetLocalTransform(joint, animated);
+        }
+        return time;
+    }
     for (unsigned int i = 0; i < size; ++i)
     {
         unsigned int joint = mTracks[i].GetId();
@@ -27,7 +157,148 @@ float Clip::Sample(Pose& outPose, float time)
     return time;
 }
 
-float Clip::AdjustTimeToFitRange(float inTime) const
+template <typename TRACK>
+template <typename POSE>
+float TClip<TRACK>::SampleInto(POSE& outPose, float time, ClipCursor& cursor)
+{
+    if (GetDuration() == 0.0f)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+
+    unsigned int size = mTracks.size();
+    if (HasTimelines())
+    {
+        const unsigned int numTimelines = static_cast<unsigned>(mTimelines.size());
+        if (cursor.mTimelines.size() != numTimelines)
+        {
+            cursor.mTimelines.resize(numTimelines);
+            cursor.mSamples.resize(numTimelines);
+        }
+        for (unsigned int i = 0; i < numTimelines; ++i)
+        {
+            cursor.mSamples[i] = mTimelines[i].Resolve(time, mLooping, cursor.mTimelines[i]);
+        }
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            unsigned int joint = mTracks[i].GetId();
+            Transform local = outPose.GetLocalTransform(joint);
+            Transform animated = mTracks[i].Sample(local, cursor.mSamples.data(), mTrackTimelines[i]);
+            outPose.SetLocalTransform(joint, animated);
+        }
+        return time;
+    }
+    if (cursor.mTracks.size() != size)
+    {
+        cursor.mTracks.resize(size);
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int joint = mTracks[i].GetId();
+        Transform local = outPose.GetLocalTransform(joint);
+        Transform animated = mTracks[i].Sample(local, time, mLooping, cursor.mTracks[i]);
+        outPose.SetLocalTransform(joint, animated);
+    }
+    return time;
+}
+
+template <typename TRACK>
+float TClip<TRACK>::Sample(Pose& outPose, float time)
+{
+    return SampleInto(outPose, time);
+}
+
+template <typename TRACK>
+float TClip<TRACK>::Sample(Pose& outPose, float time, ClipCursor& cursor)
+{
+    return SampleInto(outPose, time, cursor);
+}
+
+template <typename TRACK>
+float TClip<TRACK>::Sample(SoaPose& outPose, float time)
+{
+    return SampleInto(outPose, time);
+}
+
+template <typename TRACK>
+float TClip<TRACK>::Sample(SoaPose& outPose, float time, ClipCursor& cursor)
+{
+    return SampleInto(outPose, time, cursor);
+}
+
+template <typename TRACK>
+void TClip<TRACK>::SampleMany(const float* inTimes, Pose* outPoses, unsigned int count,
+                              ClipSampleManyScratch& scratch, float* outTimes)
+{
+    if (GetDuration() == 0.0f)
+    {
+        for (unsigned int k = 0; outTimes != nullptr && k < count; ++k)
+        {
+            outTimes[k] = 0.0f;
+        }
+        return;
+    }
+
+    scratch.mTimes.resize(count);
+    for (unsigned int k = 0; k < count; ++k)
+    {
+        scratch.mTimes[k] = AdjustTimeToFitRange(inTimes[k]);
+        if (outTimes != nullptr)
+        {
+            outTimes[k] = scratch.mTimes[k];
+        }
+    }
+
+    unsigned int size = mTracks.size();
+    if (HasTimelines())
+    {
+        // One row of resolved segments per instance
+        const unsigned int numTimelines = static_cast<unsigned>(mTimelines.size());
+        scratch.mSamples.resize(count * numTimelines);
+        for (unsigned int t = 0; t < numTimelines; ++t)
+        {
+            for (unsigned int k = 0; k < count; ++k)
+            {
+                scratch.mSamples[k * numTimelines + t] = mTimelines[t].Resolve(scratch.mTimes[k], mLooping);
+            }
+        }
+        for (unsigned int first = 0; first < count; first += CLIP_SAMPLE_MANY_BLOCK)
+        {
+            const unsigned int last = first + CLIP_SAMPLE_MANY_BLOCK < count ? first + CLIP_SAMPLE_MANY_BLOCK : count;
+            for (unsigned int i = 0; i < size; ++i)
+            {
+                unsigned int joint = mTracks[i].GetId();
+                for (unsigned int k = first; k < last; ++k)
+                {
+                    Transform local = outPoses[k].GetLocalTransform(joint);
+                    const TimelineSample* samples = &scratch.mSamples[k * numTimelines];
+                    Transform animated = mTracks[i].Sample(local, samples, mTrackTimelines[i]);
+                    outPoses[k].SetLocalTransform(joint, animated);
+                }
+            }
+        }
+        return;
+    }
+
+    for (unsigned int first = 0; first < count; first += CLIP_SAMPLE_MANY_BLOCK)
+    {
+        const unsigned int last = first + CLIP_SAMPLE_MANY_BLOCK < count ? first + CLIP_SAMPLE_MANY_BLOCK : count;
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            unsigned int joint = mTracks[i].GetId();
+            for (unsigned int k = first; k < last; ++k)
+            {
+                Transform local = outPoses[k].GetLocalTransform(joint);
+                Transform animated = mTracks[i].Sample(local, scratch.mTimes[k], mLooping);
+                outPoses[k].SetLocalTransform(joint, animated);
+            }
+        }
+    }
+}
+
+template <typename TRACK>
+float TClip<TRACK>::AdjustTimeToFitRange(float inTime) const
 {
     if (mLooping)
     {
@@ -58,7 +329,8 @@ float Clip::AdjustTimeToFitRange(float inTime) const
     return inTime;
 }
 
-void Clip::RecalculateDuration()
+template <typename TRACK>
+void TClip<TRACK>::RecalculateDuration()
 {
     mStartTime = 0.0f;
     mEndTime = 0.0f;
@@ -87,7 +359,41 @@ void Clip::RecalculateDuration()
     }
 }
 
-TransformTrack& Clip::operator[](unsigned int joint)
+template <typename TRACK>
+void TClip<TRACK>::SetTimeRange(float startTime, float endTime)
+{
+    mStartTime = startTime;
+    mEndTime = endTime;
+}
+
+template <typename TRACK>
+void TClip<TRACK>::UpdateTimelines()
+{
+    mTimelines.clear();
+    const unsigned int size = static_cast<unsigned>(mTracks.size());
+    mTrackTimelines.resize(size);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        mTrackTimelines[i].mPosition = ClipHelpers::FindOrAddTimeline(mTimelines, mTracks[i].GetPositionTrack());
+        mTrackTimelines[i].mRotation = ClipHelpers::FindOrAddTimeline(mTimelines, mTracks[i].GetRotationTrack());
+        mTrackTimelines[i].mScale = ClipHelpers::FindOrAddTimeline(mTimelines, mTracks[i].GetScaleTrack());
+    }
+}
+
+template <typename TRACK>
+unsigned int TClip<TRACK>::GetNumTimelines() const
+{
+    return static_cast<unsigned>(mTimelines.size());
+}
+
+template <typename TRACK>
+bool TClip<TRACK>::HasTimelines() const
+{
+    return !mTimelines.empty() && mTrackTimelines.size() == mTracks.size();
+}
+
+template <typename TRACK>
+TRACK& TClip<TRACK>::operator[](unsigned int joint)
 {
     for (auto& mTrack : mTracks)
     {
@@ -102,52 +408,156 @@ TransformTrack& Clip::operator[](unsigned int joint)
     return mTracks[mTracks.size() - 1];
 }
 
-std::string& Clip::GetName()
+template <typename TRACK>
+std::string& TClip<TRACK>::GetName()
 {
     return mName;
 }
 
-void Clip::SetName(const std::string& inNewName)
+template <typename TRACK>
+void TClip<TRACK>::SetName(const std::string& inNewName)
 {
     mName = inNewName;
 }
 
-unsigned int Clip::GetIdAtIndex(unsigned int index)
+template <typename TRACK>
+unsigned int TClip<TRACK>::GetIdAtIndex(unsigned int index)
 {
     return mTracks[index].GetId();
 }
 
-void Clip::SetIdAtIndex(unsigned int index, unsigned int id)
+template <typename TRACK>
+void TClip<TRACK>::SetIdAtIndex(unsigned int index, unsigned int id)
 {
     return mTracks[index].SetId(id);
 }
 
-unsigned int Clip::Size() const
+template <typename TRACK>
+void TClip<TRACK>::RemoveTrackAtIndex(unsigned int index)
+{
+    mTracks.erase(mTracks.begin() + index);
+    mTrackTimelines.clear();
+    mTimelines.clear();
+}
+
+template <typename TRACK>
+unsigned int TClip<TRACK>::Size() const
 {
     return static_cast<unsigned>(mTracks.size());
 }
 
-float Clip::GetDuration() const
+template <typename TRACK>
+float TClip<TRACK>::GetDuration() const
 {
     return mEndTime - mStartTime;
 }
 
-float Clip::GetStartTime() const
+template <typename TRACK>
+float TClip<TRACK>::GetStartTime() const
 {
     return mStartTime;
 }
 
-float Clip::GetEndTime() const
+template <typename TRACK>
+float TClip<TRACK>::GetEndTime() const
 {
     return mEndTime;
 }
 
-bool Clip::GetLooping() const
+template <typename TRACK>
+bool TClip<TRACK>::GetLooping() const
 {
     return mLooping;
 }
 
-void Clip::SetLooping(bool inLooping)
+template <typename TRACK>
+void TClip<TRACK>::SetLooping(bool inLooping)
 {
     mLooping = inLooping;
 }
+
+
+ConstantTrackStats StripConstantTracks(Clip& clip, const Pose& restPose)
+{
+    ConstantTrackStats stats;
+    for (unsigned int i = 0; i < clip.Size();)
+    {
+        TransformTrack& track = clip[clip.GetIdAtIndex(i)];
+        stats.mCollapsed += ClipHelpers::CollapseConstantTrack(track.GetPositionTrack()) ? 1 : 0;
+        stats.mCollapsed += ClipHelpers::CollapseConstantTrack(track.GetRotationTrack()) ? 1 : 0;
+        stats.mCollapsed += ClipHelpers::CollapseConstantTrack(track.GetScaleTrack()) ? 1 : 0;
+
+        const unsigned int joint = track.GetId();
+        if (joint < restPose.Size())
+        {
+            Transform rest = restPose.GetLocalTransform(joint);
+            stats.mRemoved += ClipHelpers::RemoveRestTrack(track.GetPositionTrack(), rest.position) ? 1 : 0;
+            stats.mRemoved += ClipHelpers::RemoveRestTrack(track.GetRotationTrack(), rest.rotation) ? 1 : 0;
+            stats.mRemoved += ClipHelpers::RemoveRestTrack(track.GetScaleTrack(), rest.scale) ? 1 : 0;
+        }
+
+        if (track.GetPositionTrack().Size() == 0 && track.GetRotationTrack().Size() == 0 &&
+            track.GetScaleTrack().Size() == 0)
+        {
+            clip.RemoveTrackAtIndex(i);
+            ++stats.mJointsRemoved;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    clip.UpdateTimelines();
+    return stats;
+}
+
+CompressedClip CompressClip(Clip& input, CompressionStats* outStats)
+{
+    CompressedClip result;
+
+    result.SetName(input.GetName());
+    result.SetLooping(input.GetLooping());
+    CompressionStats stats;
+    const unsigned int size = input.Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const unsigned int joint = input.GetIdAtIndex(i);
+        TransformTrack& original = input[joint];
+        CompressedTransformTrack& track = result[joint];
+        track = CompressTransformTrack(original);
+
+        stats.mOriginalBytes += (original.GetPositionTrack().Size() + original.GetScaleTrack().Size())
+            * sizeof(Frame<3>) + original.GetRotationTrack().Size() * sizeof(Frame<4>);
+        stats.mCompressedBytes += track.GetPositionTrack().GetMemorySize()
+            + track.GetRotationTrack().GetMemorySize() + track.GetScaleTrack().GetMemorySize();
+        if (outStats == nullptr)
+        {
+            continue;
+        }
+
+        const bool looping = input.GetLooping();
+        const float positionError = CompressionError(original.GetPositionTrack(), track.GetPositionTrack(), looping);
+        const float rotationError = CompressionError(original.GetRotationTrack(), track.GetRotationTrack(), looping)
+            * 57.2958f;
+        const float scaleError = CompressionError(original.GetScaleTrack(), track.GetScaleTrack(), looping);
+        TrackCompressionError trackError;
+        trackError.mJoint = joint;
+        trackError.mPositionError = positionError;
+        trackError.mRotationError = rotationError;
+        trackError.mScaleError = scaleError;
+        stats.mTracks.push_back(trackError);
+        stats.mMaxPositionError = positionError > stats.mMaxPositionError ? positionError : stats.mMaxPositionError;
+        stats.mMaxRotationError = rotationError > stats.mMaxRotationError ? rotationError : stats.mMaxRotationError;
+        stats.mMaxScaleError = scaleError > stats.mMaxScaleError ? scaleError : stats.mMaxScaleError;
+    }
+    // Copy the range, collapsed constant tracks no longer define it
+    result.SetTimeRange(input.GetStartTime(), input.GetEndTime());
+    result.UpdateTimelines();
+    if (outStats != nullptr)
+    {
+        *outStats = stats;
+    }
+
+    return result;
+}
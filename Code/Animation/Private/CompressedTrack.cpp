@@ -0,0 +1,378 @@
+#include "Animation/Public/CompressedTrack.h"
+#include "Animation/Public/TrackHelpers.h"
+#include <cmath>
+#include <cstring>
+
+template CompressedTrack<float, 1>;
+template CompressedTrack<Vec3, 3>;
+template CompressedTrack<Quat, 4>;
+
+template float CompressionError(Track<float, 1>& original, CompressedTrack<float, 1>& compressed, bool looping);
+template float CompressionError(Track<Vec3, 3>& original, CompressedTrack<Vec3, 3>& compressed, bool looping);
+template float CompressionError(Track<Quat, 4>& original, CompressedTrack<Quat, 4>& compressed, bool looping);
+
+namespace CompressionHelpers
+{
+    inline unsigned short Quantize(float unit, float maxValue)
+    {
+        if (unit < 0.0f) { unit = 0.0f; }
+        if (unit > 1.0f) { unit = 1.0f; }
+        return static_cast<unsigned short>(unit * maxValue + 0.5f);
+    }
+
+    inline float Dequantize(unsigned short quantized, float maxValue)
+    {
+        return static_cast<float>(quantized) / maxValue;
+    }
+
+    template <int N>
+    void FindRange(const float* values, unsigned int count, unsigned int stride, float* outMin, float* outExtent)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            float min = count > 0 ? values[c] : 0.0f;
+            float max = min;
+            for (unsigned int i = 1; i < count; ++i)
+            {
+                const float value = values[i * stride + c];
+                min = value < min ? value : min;
+                max = value > max ? value : max;
+            }
+            outMin[c] = min;
+            outExtent[c] = max - min;
+        }
+    }
+
+    template <int N>
+    void EncodeRange(const float* value, const float* min, const float* extent, unsigned short* outQuantized)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            outQuantized[c] = extent[c] > 0.0f ? Quantize((value[c] - min[c]) / extent[c], 65535.0f) : 0;
+        }
+    }
+
+    template <int N>
+    void DecodeRange(const unsigned short* quantized, const float* min, const float* extent, float* outValue)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            outValue[c] = min[c] + Dequantize(quantized[c], 65535.0f) * extent[c];
+        }
+    }
+} // End of CompressionHelpers
+
+template <typename T, int N>
+CompressedTrack<T, N>::CompressedTrack()
+{
+    mInterpolation = Interpolation::Linear;
+    for (int c = 0; c < N; ++c)
+    {
+        mValueMin[c] = 0.0f;
+        mValueExtent[c] = 0.0f;
+        mTangentMin[c] = 0.0f;
+        mTangentExtent[c] = 0.0f;
+    }
+}
+
+template <typename T, int N>
+void CompressedTrack<T, N>::Set(Track<T, N>& track)
+{
+    const unsigned int size = track.Size();
+    mInterpolation = track.GetInterpolation();
+    mTimes.resize(size);
+    mValues.resize(size * ValueShorts);
+    mInTangents.clear();
+    mOutTangents.clear();
+    if (size == 0)
+    {
+        return;
+    }
+
+    const unsigned int stride = sizeof(Frame<N>) / sizeof(float);
+    CompressionHelpers::FindRange<N>(track[0].mValue, size, stride, mValueMin, mValueExtent);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        mTimes[i] = track[i].mTime;
+        EncodeValue(track[i].mValue, &mValues[i * ValueShorts]);
+    }
+
+    if (mInterpolation != Interpolation::Cubic)
+    {
+        return;
+    }
+
+    // In and out tangents share one range
+    float inMin[N], inExtent[N], outMin[N], outExtent[N];
+    CompressionHelpers::FindRange<N>(track[0].mIn, size, stride, inMin, inExtent);
+    CompressionHelpers::FindRange<N>(track[0].mOut, size, stride, outMin, outExtent);
+    for (int c = 0; c < N; ++c)
+    {
+        const float min = inMin[c] < outMin[c] ? inMin[c] : outMin[c];
+        const float inMax = inMin[c] + inExtent[c];
+        const float outMax = outMin[c] + outExtent[c];
+        mTangentMin[c] = min;
+        mTangentExtent[c] = (inMax > outMax ? inMax : outMax) - min;
+    }
+
+    mInTangents.resize(size * N);
+    mOutTangents.resize(size * N);
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        CompressionHelpers::EncodeRange<N>(track[i].mIn, mTangentMin, mTangentExtent, &mInTangents[i * N]);
+        CompressionHelpers::EncodeRange<N>(track[i].mOut, mTangentMin, mTangentExtent, &mOutTangents[i * N]);
+    }
+}
+
+template <typename T, int N>
+void CompressedTrack<T, N>::EncodeValue(const float* value, unsigned short* outQuantized)
+{
+    CompressionHelpers::EncodeRange<N>(value, mValueMin, mValueExtent, outQuantized);
+}
+
+template <>
+void CompressedTrack<Quat, 4>::EncodeValue(const float* value, unsigned short* outQuantized)
+{
+    Quat q = TrackHelpers::Cast<Quat>(value);
+
+    int largest = 0;
+    for (int c = 1; c < 4; ++c)
+    {
+        if (fabsf(q.v[c]) > fabsf(q.v[largest]))
+        {
+            largest = c;
+        }
+    }
+    int packed = 0;
+    for (int c = 0; c < 4; ++c)
+    {
+        if (c != largest)
+        {
+            const float unit = (q.v[c] / COMPRESSED_QUAT_SCALE) * 0.5f + 0.5f;
+            outQuantized[packed++] = CompressionHelpers::Quantize(unit, 32767.0f);
+        }
+    }
+    // Two bits for the dropped component and one for its sign, in the top bits of the shorts.
+    // The sign is kept rather than flipping q, cubic tangents were authored against this hemisphere.
+    outQuantized[0] |= static_cast<unsigned short>((largest >> 1) << 15);
+    outQuantized[1] |= static_cast<unsigned short>((largest & 1) << 15);
+    outQuantized[2] |= static_cast<unsigned short>((q.v[largest] < 0.0f ? 1 : 0) << 15);
+}
+
+template <typename T, int N>
+T CompressedTrack<T, N>::DecodeValue(unsigned int frame)
+{
+    float value[N];
+    CompressionHelpers::DecodeRange<N>(&mValues[frame * ValueShorts], mValueMin, mValueExtent, value);
+    return TrackHelpers::Cast<T>(value);
+}
+
+template <>
+Quat CompressedTrack<Quat, 4>::DecodeValue(unsigned int frame)
+{
+    const unsigned short* quantized = &mValues[frame * ValueShorts];
+    const int largest = ((quantized[0] >> 15) << 1) | (quantized[1] >> 15);
+
+    Quat result;
+    float lenSq = 0.0f;
+    int packed = 0;
+    for (int c = 0; c < 4; ++c)
+    {
+        if (c != largest)
+        {
+            const float unit = CompressionHelpers::Dequantize(quantized[packed++] & 0x7fff, 32767.0f);
+            result.v[c] = (unit * 2.0f - 1.0f) * COMPRESSED_QUAT_SCALE;
+            lenSq += result.v[c] * result.v[c];
+        }
+    }
+    result.v[largest] = sqrtf(lenSq < 1.0f ? 1.0f - lenSq : 0.0f);
+    if (quantized[2] >> 15)
+    {
+        result.v[largest] = -result.v[largest];
+    }
+    return result.Normalized();
+}
+
+template <typename T, int N>
+T CompressedTrack<T, N>::DecodeTangent(const std::vector<unsigned short>& tangents, unsigned int frame)
+{
+    float value[N];
+    CompressionHelpers::DecodeRange<N>(&tangents[frame * N], mTangentMin, mTangentExtent, value);
+    T result;
+    memcpy(&result, value, N * sizeof(float));
+    return result;
+}
+
+template <typename T, int N>
+unsigned int CompressedTrack<T, N>::Size()
+{
+    return static_cast<unsigned>(mTimes.size());
+}
+
+template <typename T, int N>
+unsigned int CompressedTrack<T, N>::GetMemorySize()
+{
+    return static_cast<unsigned>(mTimes.size() * sizeof(float) +
+        (mValues.size() + mInTangents.size() + mOutTangents.size()) * sizeof(unsigned short));
+}
+
+template <typename T, int N>
+Interpolation CompressedTrack<T, N>::GetInterpolation() const
+{
+    return mInterpolation;
+}
+
+template <typename T, int N>
+float CompressedTrack<T, N>::GetStartTime()
+{
+    if (mTimes.size() == 0)
+    {
+        return 0.0f;
+    }
+    return mTimes[0];
+}
+
+template <typename T, int N>
+float CompressedTrack<T, N>::GetEndTime()
+{
+    if (mTimes.size() == 0)
+    {
+        return 0.0f;
+    }
+    return mTimes[mTimes.size() - 1];
+}
+
+template <typename T, int N>
+float CompressedTrack<T, N>::AdjustTimeToFitTrack(float time, bool looping)
+{
+    if (mTimes.empty())
+    {
+        return 0.0f;
+    }
+    return TrackHelpers::AdjustTimeToFitTimes(&mTimes[0], 1, static_cast<unsigned>(mTimes.size()), time, looping);
+}
+
+template <typename T, int N>
+int CompressedTrack<T, N>::FrameIndex(float trackTime)
+{
+    return TrackHelpers::FrameIndexBinary(&mTimes[0], 1, static_cast<unsigned>(mTimes.size()), trackTime);
+}
+
+template <typename T, int N>
+int CompressedTrack<T, N>::FrameIndex(float trackTime, TrackCursor& cursor)
+{
+    return TrackHelpers::FrameIndexFromCursor(&mTimes[0], 1, static_cast<unsigned>(mTimes.size()), trackTime, cursor);
+}
+
+template <typename T, int N>
+T CompressedTrack<T, N>::SampleSegment(int thisFrame, float trackTime)
+{
+    if (mInterpolation == Interpolation::Constant)
+    {
+        return DecodeValue(thisFrame);
+    }
+
+    const int nextFrame = thisFrame + 1;
+    const float frameDelta = mTimes[nextFrame] - mTimes[thisFrame];
+    if (frameDelta <= 0.0f)
+    {
+        return T();
+    }
+    const float t = (trackTime - mTimes[thisFrame]) / frameDelta;
+
+    T start = DecodeValue(thisFrame);
+    T end = DecodeValue(nextFrame);
+    if (mInterpolation == Interpolation::Linear)
+    {
+        return TrackHelpers::Interpolate(start, end, t);
+    }
+
+    T slope1 = DecodeTangent(mOutTangents, thisFrame) * frameDelta;
+    T slope2 = DecodeTangent(mInTangents, nextFrame) * frameDelta;
+    return TrackHelpers::Hermite(t, start, slope1, end, slope2);
+}
+
+template <typename T, int N>
+T CompressedTrack<T, N>::Sample(float time, bool looping)
+{
+    if (mTimes.size() <= 1)
+    {
+        return mTimes.empty() ? T() : DecodeValue(0);
+    }
+    const float trackTime = AdjustTimeToFitTrack(time, looping);
+    return SampleSegment(FrameIndex(trackTime), trackTime);
+}
+
+template <typename T, int N>
+T CompressedTrack<T, N>::Sample(float time, bool looping, TrackCursor& cursor)
+{
+    if (mTimes.size() <= 1)
+    {
+        return mTimes.empty() ? T() : DecodeValue(0);
+    }
+    const float trackTime = AdjustTimeToFitTrack(time, looping);
+    return SampleSegment(FrameIndex(trackTime, cursor), trackTime);
+}
+
+template <typename T, int N>
+T CompressedTrack<T, N>::Sample(const TimelineSample& sample)
+{
+    if (mTimes.size() <= 1)
+    {
+        return mTimes.empty() ? T() : DecodeValue(0);
+    }
+
+    const int thisFrame = sample.mFrame;
+    if (mInterpolation == Interpolation::Constant)
+    {
+        return DecodeValue(thisFrame);
+    }
+
+    const int nextFrame = thisFrame + 1;
+    const float frameDelta = mTimes[nextFrame] - mTimes[thisFrame];
+    if (frameDelta <= 0.0f)
+    {
+        return T();
+    }
+
+    T start = DecodeValue(thisFrame);
+    T end = DecodeValue(nextFrame);
+    if (mInterpolation == Interpolation::Linear)
+    {
+        return TrackHelpers::Interpolate(start, end, sample.mT);
+    }
+
+    T slope1 = DecodeTangent(mOutTangents, thisFrame) * frameDelta;
+    T slope2 = DecodeTangent(mInTangents, nextFrame) * frameDelta;
+    return TrackHelpers::Hermite(sample.mT, start, slope1, end, slope2);
+}
+
+template <typename T, int N>
+float CompressedTrack<T, N>::GetTime(unsigned int index)
+{
+    return mTimes[index];
+}
+
+template <typename T, int N>
+float CompressionError(Track<T, N>& original, CompressedTrack<T, N>& compressed, bool looping)
+{
+    const unsigned int size = original.Size();
+    if (size <= 1)
+    {
+        return 0.0f;
+    }
+
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i + 1 < size; ++i)
+    {
+        const float thisTime = original[i].mTime;
+        const float halfway = (thisTime + original[i + 1].mTime) * 0.5f;
+        float error = TrackHelpers::Difference(original.Sample(thisTime, looping),
+                                                     compressed.Sample(thisTime, looping));
+        maxError = error > maxError ? error : maxError;
+        error = TrackHelpers::Difference(original.Sample(halfway, looping),
+                                               compressed.Sample(halfway, looping));
+        maxError = error > maxError ? error : maxError;
+    }
+    return maxError;
+}
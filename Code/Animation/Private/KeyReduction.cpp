@@ -0,0 +1,205 @@
+#include "Animation/Public/KeyReduction.h"
+#include "Animation/Public/TrackHelpers.h"
+
+template unsigned int ReduceTrack(Track<float, 1>& track, float tolerance);
+template unsigned int ReduceTrack(Track<Vec3, 3>& track, float tolerance);
+template unsigned int ReduceTrack(Track<Quat, 4>& track, float tolerance);
+
+// Sample rate used to measure the model space error of a reduced clip
+#define KEY_REDUCTION_MEASURE_RATE 120.0f
+
+namespace KeyReductionHelpers
+{
+    // Error at key "frame" when the keys between "first" and "last" are dropped
+    template <typename T, int N>
+    float KeyError(Track<T, N>& track, unsigned int first, unsigned int last, unsigned int frame)
+    {
+        T value = TrackHelpers::Cast<T>(track[frame].mValue);
+        T start = TrackHelpers::Cast<T>(track[first].mValue);
+        if (track.GetInterpolation() == Interpolation::Constant)
+        {
+            return TrackHelpers::Difference(start, value);
+        }
+
+        const float frameDelta = track[last].mTime - track[first].mTime;
+        if (frameDelta <= 0.0f)
+        {
+            return TrackHelpers::Difference(start, value);
+        }
+        const float t = (track[frame].mTime - track[first].mTime) / frameDelta;
+        T end = TrackHelpers::Cast<T>(track[last].mValue);
+        return TrackHelpers::Difference(TrackHelpers::Interpolate(start, end, t), value);
+    }
+
+    unsigned int CountKeys(TransformTrack& track)
+    {
+        return track.GetPositionTrack().Size() + track.GetRotationTrack().Size() + track.GetScaleTrack().Size();
+    }
+
+    unsigned int CountKeys(Clip& clip)
+    {
+        unsigned int count = 0;
+        for (unsigned int i = 0, size = clip.Size(); i < size; ++i)
+        {
+            count += CountKeys(clip[clip.GetIdAtIndex(i)]);
+        }
+        return count;
+    }
+
+    // Reach is the furthest any descendant gets from a joint in the rest pose or while the clip
+    // plays, depth is the longest parent chain
+    void MeasureReach(Clip& clip, Pose& restPose, std::vector<float>& outReach, unsigned int& outMaxDepth)
+    {
+        const unsigned int numJoints = restPose.Size();
+        outReach.assign(numJoints, 0.0f);
+        outMaxDepth = 1;
+
+        Pose pose = restPose;
+        std::vector<Transform> world(numJoints);
+        const float startTime = clip.GetStartTime();
+        const float duration = clip.GetDuration();
+        const unsigned int numSamples = static_cast<unsigned>(duration * KEY_REDUCTION_MEASURE_RATE) + 1;
+        for (unsigned int s = 0; s <= numSamples + 1; ++s)
+        {
+            // The first pass measures the rest pose itself
+            if (s > 0)
+            {
+                clip.Sample(pose, startTime + duration * static_cast<float>(s - 1) / static_cast<float>(numSamples));
+            }
+            for (unsigned int j = 0; j < numJoints; ++j)
+            {
+                world[j] = pose.GetGlobalTransform(j);
+            }
+
+            for (unsigned int j = 0; j < numJoints; ++j)
+            {
+                unsigned int depth = 1;
+                for (int parent = pose.GetParent(j); parent >= 0; parent = pose.GetParent(parent))
+                {
+                    const float distance = TrackHelpers::Difference(world[j].position, world[parent].position);
+                    outReach[parent] = distance > outReach[parent] ? distance : outReach[parent];
+                    ++depth;
+                }
+                outMaxDepth = depth > outMaxDepth ? depth : outMaxDepth;
+            }
+        }
+    }
+
+    // Largest model space position, orientation and scale difference between two clips
+    void MeasureError(Clip& original, Clip& reduced, Pose& restPose, float& outPosition, float& outAngle,
+                      float& outScale)
+    {
+        outPosition = 0.0f;
+        outAngle = 0.0f;
+        outScale = 0.0f;
+        const unsigned int numJoints = restPose.Size();
+        Pose originalPose = restPose;
+        Pose reducedPose = restPose;
+
+        const float startTime = original.GetStartTime();
+        const float duration = original.GetDuration();
+        const unsigned int numSamples = static_cast<unsigned>(duration * KEY_REDUCTION_MEASURE_RATE) + 1;
+        for (unsigned int s = 0; s <= numSamples; ++s)
+        {
+            const float time = startTime + duration * static_cast<float>(s) / static_cast<float>(numSamples);
+            original.Sample(originalPose, time);
+            reduced.Sample(reducedPose, time);
+
+            for (unsigned int j = 0; j < numJoints; ++j)
+            {
+                Transform a = originalPose.GetGlobalTransform(j);
+                Transform b = reducedPose.GetGlobalTransform(j);
+                const float position = TrackHelpers::Difference(a.position, b.position);
+                const float angle = TrackHelpers::Difference(a.rotation, b.rotation);
+                const float scale = TrackHelpers::Difference(a.scale, b.scale);
+                outPosition = position > outPosition ? position : outPosition;
+                outAngle = angle > outAngle ? angle : outAngle;
+                outScale = scale > outScale ? scale : outScale;
+            }
+        }
+    }
+} // End of KeyReductionHelpers
+
+template <typename T, int N>
+unsigned int ReduceTrack(Track<T, N>& track, float tolerance)
+{
+    const unsigned int size = track.Size();
+    if (size <= 2 || track.GetInterpolation() == Interpolation::Cubic)
+    {
+        return 0;
+    }
+
+    // Grow the segment from the last kept key for as long as every key it skips stays in tolerance
+    std::vector<Frame<N>> kept;
+    kept.reserve(size);
+    kept.push_back(track[0]);
+    unsigned int anchor = 0;
+    for (unsigned int last = 2; last < size; ++last)
+    {
+        bool fits = true;
+        for (unsigned int frame = anchor + 1; frame < last && fits; ++frame)
+        {
+            fits = KeyReductionHelpers::KeyError(track, anchor, last, frame) <= tolerance;
+        }
+        if (!fits)
+        {
+            anchor = last - 1;
+            kept.push_back(track[anchor]);
+        }
+    }
+    kept.push_back(track[size - 1]);
+
+    const unsigned int numKept = static_cast<unsigned>(kept.size());
+    track.Resize(numKept);
+    for (unsigned int i = 0; i < numKept; ++i)
+    {
+        track[i] = kept[i];
+    }
+    return size - numKept;
+}
+
+KeyReductionStats ReduceClip(Clip& clip, Skeleton& skeleton, const KeyReductionSettings& settings)
+{
+    Pose& restPose = skeleton.GetRestPose();
+    const unsigned int numJoints = restPose.Size();
+
+    std::vector<float> reach;
+    unsigned int maxDepth = 1;
+    KeyReductionHelpers::MeasureReach(clip, restPose, reach, maxDepth);
+
+    // Every joint on the longest chain may use an equal share of the model space tolerance,
+    // half for its own translation and half for what its rotation and scale do to its children
+    const float positionShare = settings.mPositionTolerance / static_cast<float>(maxDepth);
+    const float angleShare = settings.mAngleTolerance * 0.0174533f / static_cast<float>(maxDepth);
+    const float scaleShare = settings.mScaleTolerance / static_cast<float>(maxDepth);
+
+    Clip original = clip;
+    for (unsigned int i = 0, size = clip.Size(); i < size; ++i)
+    {
+        const unsigned int joint = clip.GetIdAtIndex(i);
+        const float jointReach = joint < numJoints ? reach[joint] : 0.0f;
+
+        float angleTolerance = angleShare;
+        float scaleTolerance = scaleShare;
+        if (jointReach > 0.0f)
+        {
+            const float limit = positionShare * 0.5f / jointReach;
+            angleTolerance = limit < angleTolerance ? limit : angleTolerance;
+            scaleTolerance = limit < scaleTolerance ? limit : scaleTolerance;
+        }
+
+        TransformTrack& track = clip[joint];
+        ReduceTrack(track.GetPositionTrack(), positionShare * 0.5f);
+        ReduceTrack(track.GetRotationTrack(), angleTolerance);
+        ReduceTrack(track.GetScaleTrack(), scaleTolerance);
+    }
+    clip.UpdateTimelines();
+
+    KeyReductionStats stats;
+    stats.mKeysBefore = KeyReductionHelpers::CountKeys(original);
+    stats.mKeysAfter = KeyReductionHelpers::CountKeys(clip);
+    KeyReductionHelpers::MeasureError(original, clip, restPose, stats.mMaxPositionError, stats.mMaxAngleError,
+                                      stats.mMaxScaleError);
+    stats.mMaxAngleError *= 57.2958f;
+    return stats;
+}
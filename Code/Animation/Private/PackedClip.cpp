@@ -0,0 +1,913 @@
+#include "Animation/Public/PackedClip.h"
+#include "Animation/Public/TrackHelpers.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace PackedClipHelpers
+{
+    // Every section and every track slice starts on a 16 byte boundary
+    inline unsigned int AlignFloats(unsigned int count)
+    {
+        return (count + 3) & ~3u;
+    }
+
+    inline unsigned int ComponentSize(PackedComponent component)
+    {
+        return component == PackedComponent::Rotation ? 4 : 3;
+    }
+
+    // Tracks are sorted by group, then by joint
+    inline unsigned int GroupIndex(PackedComponent component, Interpolation interpolation)
+    {
+        return static_cast<unsigned>(component) * 3 + static_cast<unsigned>(interpolation);
+    }
+
+    template <typename TRACK>
+    void AddTrack(std::vector<PackedTrack>& outTracks, TRACK& track, unsigned int joint, PackedComponent component)
+    {
+        if (track.Size() == 0)
+        {
+            return;
+        }
+        PackedTrack packed;
+        packed.mJoint = joint;
+        packed.mComponent = component;
+        // A single key is constant whatever the track says, and needs no tangents
+        packed.mInterpolation = track.Size() == 1 ? Interpolation::Constant : track.GetInterpolation();
+        packed.mNumFrames = track.Size();
+        packed.mTimeOffset = 0;
+        packed.mValueOffset = 0;
+        packed.mTangentOffset = 0;
+        outTracks.push_back(packed);
+    }
+
+    template <typename T, int N>
+    void GetKeyTimes(Track<T, N>& track, std::vector<float>& outTimes)
+    {
+        const unsigned int size = track.Size();
+        outTimes.resize(size);
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            outTimes[i] = track.GetTime(i);
+        }
+    }
+
+    void GetKeyTimes(Clip& clip, const PackedTrack& packed, std::vector<float>& outTimes)
+    {
+        TransformTrack& track = clip[packed.mJoint];
+        if (packed.mComponent == PackedComponent::Position)
+        {
+            GetKeyTimes(track.GetPositionTrack(), outTimes);
+        }
+        else if (packed.mComponent == PackedComponent::Rotation)
+        {
+            GetKeyTimes(track.GetRotationTrack(), outTimes);
+        }
+        else
+        {
+            GetKeyTimes(track.GetScaleTrack(), outTimes);
+        }
+    }
+
+    // Offset of an identical run already in the section, or of a new aligned one
+    unsigned int FindOrAddTimes(std::vector<float>& section, std::vector<PackedTimeRun>& runs,
+                                const std::vector<float>& times)
+    {
+        const unsigned int size = static_cast<unsigned>(times.size());
+        for (unsigned int i = 0, numRuns = static_cast<unsigned>(runs.size()); i < numRuns; ++i)
+        {
+            if (runs[i].mNumFrames == size && memcmp(&section[runs[i].mOffset], times.data(), size * sizeof(float)) == 0)
+            {
+                return runs[i].mOffset;
+            }
+        }
+        PackedTimeRun run;
+        run.mOffset = static_cast<unsigned>(section.size());
+        run.mNumFrames = size;
+        runs.push_back(run);
+        section.insert(section.end(), times.begin(), times.end());
+        section.resize(run.mOffset + AlignFloats(size), 0.0f);
+        return run.mOffset;
+    }
+
+    template <typename T, int N>
+    void CopyFrames(Track<T, N>& track, const PackedTrack& packed, float* values,
+                    float* inTangents, float* outTangents)
+    {
+        const bool hasTangents = packed.mInterpolation == Interpolation::Cubic;
+        for (unsigned int i = 0; i < packed.mNumFrames; ++i)
+        {
+            Frame<N>& frame = track[i];
+            memcpy(&values[packed.mValueOffset + i * N], frame.mValue, N * sizeof(float));
+            if (hasTangents)
+            {
+                memcpy(&inTangents[packed.mTangentOffset + i * N], frame.mIn, N * sizeof(float));
+                memcpy(&outTangents[packed.mTangentOffset + i * N], frame.mOut, N * sizeof(float));
+            }
+        }
+    }
+
+    // Segment and blend factor, samplers check the segment length themselves
+    inline TimelineSample MakeSample(const float* times, unsigned int numFrames, int frame, float trackTime)
+    {
+        TimelineSample result;
+        result.mFrame = frame;
+        result.mT = 0.0f;
+        if (numFrames > 1 && times[frame + 1] - times[frame] > 0.0f)
+        {
+            result.mT = (trackTime - times[frame]) / (times[frame + 1] - times[frame]);
+        }
+        return result;
+    }
+
+    // Everything one Sample call reads. Without run samples each track resolves its own run.
+    struct SampleContext
+    {
+        const float* mTimes;
+        const float* mValues;
+        const float* mInTangents;
+        const float* mOutTangents;
+        const PackedTrack* mTracks;
+        const PackedTimeRun* mTimeRuns;
+        const unsigned int* mTrackRuns;
+        const unsigned int* mLookupTable;
+        const TimelineSample* mRunSamples;
+        float mLookupRate;
+        float mTime;
+        bool mLooping;
+    };
+
+    // Segment of a time run at the context's time. A run with a lookup table finds it with one
+    // table load, otherwise the cursor walks forward from the last segment, or a binary search does.
+    inline TimelineSample ResolveRun(const SampleContext& data, const PackedTimeRun& run, TrackCursor* cursor)
+    {
+        const float* times = data.mTimes + run.mOffset;
+        if (run.mNumFrames <= 1)
+        {
+            return MakeSample(times, run.mNumFrames, 0, 0.0f);
+        }
+
+        const float trackTime = TrackHelpers::AdjustTimeToFitTimes(times, 1, run.mNumFrames, data.mTime, data.mLooping);
+        int frame = 0;
+        if (run.mTableSize > 0)
+        {
+            frame = TrackHelpers::FrameIndexFromTable(data.mLookupTable + run.mTableOffset, run.mTableSize,
+                                                      data.mLookupRate, times, 1, run.mNumFrames, trackTime);
+            if (cursor != nullptr)
+            {
+                cursor->mFrame = frame;
+            }
+        }
+        else if (cursor != nullptr)
+        {
+            frame = TrackHelpers::FrameIndexFromCursor(times, 1, run.mNumFrames, trackTime, *cursor);
+        }
+        else
+        {
+            frame = TrackHelpers::FrameIndexBinary(times, 1, run.mNumFrames, trackTime);
+        }
+        return MakeSample(times, run.mNumFrames, frame, trackTime);
+    }
+
+    inline TimelineSample GetSample(const SampleContext& data, const PackedTrack* track)
+    {
+        const unsigned int run = data.mTrackRuns[track - data.mTracks];
+        if (data.mRunSamples != nullptr)
+        {
+            return data.mRunSamples[run];
+        }
+        return ResolveRun(data, data.mTimeRuns[run], nullptr);
+    }
+
+    template <typename T, int N, Interpolation I>
+    struct Sampler;
+
+    template <typename T, int N>
+    struct Sampler<T, N, Interpolation::Constant>
+    {
+        static T Sample(const PackedTrack& track, const SampleContext& data, const TimelineSample& sample)
+        {
+            return TrackHelpers::Cast<T>(&data.mValues[track.mValueOffset + sample.mFrame * N]);
+        }
+    };
+
+    template <typename T, int N>
+    struct Sampler<T, N, Interpolation::Linear>
+    {
+        static T Sample(const PackedTrack& track, const SampleContext& data, const TimelineSample& sample)
+        {
+            const float* times = data.mTimes + track.mTimeOffset;
+            const float* values = data.mValues + track.mValueOffset;
+            const int thisFrame = sample.mFrame;
+            const int nextFrame = thisFrame + 1;
+            if (times[nextFrame] - times[thisFrame] <= 0.0f)
+            {
+                return T();
+            }
+
+            T start = TrackHelpers::Cast<T>(&values[thisFrame * N]);
+            T end = TrackHelpers::Cast<T>(&values[nextFrame * N]);
+            return TrackHelpers::Interpolate(start, end, sample.mT);
+        }
+    };
+
+    template <typename T, int N>
+    struct Sampler<T, N, Interpolation::Cubic>
+    {
+        static T Sample(const PackedTrack& track, const SampleContext& data, const TimelineSample& sample)
+        {
+            const float* times = data.mTimes + track.mTimeOffset;
+            const float* values = data.mValues + track.mValueOffset;
+            const int thisFrame = sample.mFrame;
+            const int nextFrame = thisFrame + 1;
+            const float frameDelta = times[nextFrame] - times[thisFrame];
+            if (frameDelta <= 0.0f)
+            {
+                return T();
+            }
+
+            T point1 = TrackHelpers::Cast<T>(&values[thisFrame * N]);
+            T slope1;
+            memcpy(&slope1, &data.mOutTangents[track.mTangentOffset + thisFrame * N], N * sizeof(float));
+            slope1 = slope1 * frameDelta;
+
+            T point2 = TrackHelpers::Cast<T>(&values[nextFrame * N]);
+            T slope2;
+            memcpy(&slope2, &data.mInTangents[track.mTangentOffset + nextFrame * N], N * sizeof(float));
+            slope2 = slope2 * frameDelta;
+
+            return TrackHelpers::Hermite(sample.mT, point1, slope1, point2, slope2);
+        }
+    };
+
+    // Writes one sampled component the way SetLocalTransform would, so unchanged joints stay clean
+    template <typename T, int N>
+    inline void SetComponent(Pose& outPose, unsigned int joint, T Transform::* component, SoaChannel,
+                             const T& value)
+    {
+        Transform local = outPose.GetLocalTransform(joint);
+        local.*component = value;
+        outPose.SetLocalTransform(joint, local);
+    }
+
+    // The lanes of a component are consecutive channels, the joint's other channels are not touched
+    template <typename T, int N>
+    inline void SetComponent(SoaPose& outPose, unsigned int joint, T Transform::*, SoaChannel firstChannel,
+                             const T& value)
+    {
+        for (int c = 0; c < N; ++c)
+        {
+            outPose.GetChannel(static_cast<SoaChannel>(static_cast<int>(firstChannel) + c))[joint] = value.v[c];
+        }
+    }
+
+    template <typename T, int N, Interpolation I, typename POSE>
+    void SampleGroup(const PackedTrack* begin, const PackedTrack* end, T Transform::* component,
+                     SoaChannel firstChannel, const SampleContext& data, POSE& outPose)
+    {
+        for (const PackedTrack* track = begin; track != end; ++track)
+        {
+            SetComponent<T, N>(outPose, track->mJoint, component, firstChannel,
+                               Sampler<T, N, I>::Sample(*track, data, GetSample(data, track)));
+        }
+    }
+
+#if PACKED_CLIP_SSE
+    // Keys and blend factor of one linear track at the sample time
+    struct LinearLane
+    {
+        const float* mStart;
+        const float* mEnd;
+        float mT;
+    };
+
+    // Value of Vec3() and Quat(), blended when a segment has no length, like Track returns T()
+    static const float kDefaultValues[2][4] = { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } };
+
+    template <int N>
+    inline void FindLinearLane(const PackedTrack* track, const SampleContext& data, LinearLane& outLane)
+    {
+        const TimelineSample sample = GetSample(data, track);
+        const float* times = data.mTimes + track->mTimeOffset;
+        const float* values = data.mValues + track->mValueOffset;
+        const int thisFrame = sample.mFrame;
+        if (times[thisFrame + 1] - times[thisFrame] <= 0.0f)
+        {
+            outLane.mStart = kDefaultValues[N == 4 ? 1 : 0];
+            outLane.mEnd = outLane.mStart;
+            outLane.mT = 0.0f;
+            return;
+        }
+        outLane.mStart = &values[thisFrame * N];
+        outLane.mEnd = &values[(thisFrame + 1) * N];
+        outLane.mT = sample.mT;
+    }
+
+    // Vec3::Lerp on four lanes
+    inline void BlendLanes(const LinearLane* lanes, Vec3** outputs)
+    {
+        alignas(16) float start[3][4];
+        alignas(16) float end[3][4];
+        alignas(16) float t[4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                start[c][lane] = lanes[lane].mStart[c];
+                end[c][lane] = lanes[lane].mEnd[c];
+            }
+            t[lane] = lanes[lane].mT;
+        }
+
+        const __m128 blend = _mm_load_ps(t);
+        alignas(16) float result[3][4];
+        for (int c = 0; c < 3; ++c)
+        {
+            const __m128 s = _mm_load_ps(start[c]);
+            const __m128 e = _mm_load_ps(end[c]);
+            _mm_store_ps(result[c], _mm_add_ps(s, _mm_mul_ps(_mm_sub_ps(e, s), blend)));
+        }
+
+        for (int lane = 0; lane < 4 && outputs[lane] != nullptr; ++lane)
+        {
+            *outputs[lane] = Vec3(result[0][lane], result[1][lane], result[2][lane]);
+        }
+    }
+
+    // Quat::Normalized on four lanes, a near zero quaternion becomes the identity
+    inline void NormalizeLanes(__m128& x, __m128& y, __m128& z, __m128& w)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                                   _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+        const __m128 degenerate = _mm_cmplt_ps(lenSq, _mm_set1_ps(QUAT_EPSILON));
+        const __m128 invLen = _mm_div_ps(one, _mm_sqrt_ps(lenSq));
+        x = _mm_andnot_ps(degenerate, _mm_mul_ps(x, invLen));
+        y = _mm_andnot_ps(degenerate, _mm_mul_ps(y, invLen));
+        z = _mm_andnot_ps(degenerate, _mm_mul_ps(z, invLen));
+        w = _mm_or_ps(_mm_andnot_ps(degenerate, _mm_mul_ps(w, invLen)), _mm_and_ps(degenerate, one));
+    }
+
+    // TrackHelpers::Interpolate on four lanes, neighborhood flip and normalization included
+    inline void BlendLanes(const LinearLane* lanes, Quat** outputs)
+    {
+        __m128 ax = _mm_loadu_ps(lanes[0].mStart);
+        __m128 ay = _mm_loadu_ps(lanes[1].mStart);
+        __m128 az = _mm_loadu_ps(lanes[2].mStart);
+        __m128 aw = _mm_loadu_ps(lanes[3].mStart);
+        _MM_TRANSPOSE4_PS(ax, ay, az, aw);
+        __m128 bx = _mm_loadu_ps(lanes[0].mEnd);
+        __m128 by = _mm_loadu_ps(lanes[1].mEnd);
+        __m128 bz = _mm_loadu_ps(lanes[2].mEnd);
+        __m128 bw = _mm_loadu_ps(lanes[3].mEnd);
+        _MM_TRANSPOSE4_PS(bx, by, bz, bw);
+
+        // Cast<Quat> normalizes every key it reads
+        NormalizeLanes(ax, ay, az, aw);
+        NormalizeLanes(bx, by, bz, bw);
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                                                 _mm_mul_ps(az, bz)), _mm_mul_ps(aw, bw));
+        const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), _mm_set1_ps(-0.0f));
+        bx = _mm_xor_ps(bx, flip);
+        by = _mm_xor_ps(by, flip);
+        bz = _mm_xor_ps(bz, flip);
+        bw = _mm_xor_ps(bw, flip);
+
+        const __m128 t = _mm_set_ps(lanes[3].mT, lanes[2].mT, lanes[1].mT, lanes[0].mT);
+        const __m128 oneMinusT = _mm_sub_ps(one, t);
+        __m128 rx = _mm_add_ps(_mm_mul_ps(ax, oneMinusT), _mm_mul_ps(bx, t));
+        __m128 ry = _mm_add_ps(_mm_mul_ps(ay, oneMinusT), _mm_mul_ps(by, t));
+        __m128 rz = _mm_add_ps(_mm_mul_ps(az, oneMinusT), _mm_mul_ps(bz, t));
+        __m128 rw = _mm_add_ps(_mm_mul_ps(aw, oneMinusT), _mm_mul_ps(bw, t));
+
+        NormalizeLanes(rx, ry, rz, rw);
+
+        _MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+        const __m128 result[4] = { rx, ry, rz, rw };
+        for (int lane = 0; lane < 4 && outputs[lane] != nullptr; ++lane)
+        {
+            _mm_storeu_ps(outputs[lane]->v, result[lane]);
+        }
+    }
+
+    // Lanes past the end of the group blend the default value and are not written
+    template <int N>
+    inline void FindLinearLanes(const PackedTrack* track, const PackedTrack* end, const SampleContext& data,
+                                LinearLane* outLanes)
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            if (track + lane < end)
+            {
+                FindLinearLane<N>(track + lane, data, outLanes[lane]);
+            }
+            else
+            {
+                outLanes[lane].mStart = kDefaultValues[N == 4 ? 1 : 0];
+                outLanes[lane].mEnd = outLanes[lane].mStart;
+                outLanes[lane].mT = 0.0f;
+            }
+        }
+    }
+
+    // Blends straight into the pose's joint array
+    template <typename T, int N>
+    void SampleLinearGroup(const PackedTrack* begin, const PackedTrack* end, T Transform::* component,
+                           SoaChannel, const SampleContext& data, Pose& outPose)
+    {
+        Transform* joints = outPose.GetLocalTransforms();
+        for (const PackedTrack* track = begin; track < end; track += 4)
+        {
+            LinearLane lanes[4];
+            FindLinearLanes<N>(track, end, data, lanes);
+            T* outputs[4] = { nullptr, nullptr, nullptr, nullptr };
+            for (int lane = 0; lane < 4 && track + lane < end; ++lane)
+            {
+                outputs[lane] = &(joints[track[lane].mJoint].*component);
+                outPose.MarkDirty(track[lane].mJoint);
+            }
+            BlendLanes(lanes, outputs);
+        }
+    }
+
+    // Blends into four values, then scatters them into the component's channels
+    template <typename T, int N>
+    void SampleLinearGroup(const PackedTrack* begin, const PackedTrack* end, T Transform::* component,
+                           SoaChannel firstChannel, const SampleContext& data, SoaPose& outPose)
+    {
+        for (const PackedTrack* track = begin; track < end; track += 4)
+        {
+            LinearLane lanes[4];
+            FindLinearLanes<N>(track, end, data, lanes);
+            T values[4];
+            T* outputs[4] = { nullptr, nullptr, nullptr, nullptr };
+            for (int lane = 0; lane < 4 && track + lane < end; ++lane)
+            {
+                outputs[lane] = &values[lane];
+            }
+            BlendLanes(lanes, outputs);
+            for (int lane = 0; lane < 4 && track + lane < end; ++lane)
+            {
+                SetComponent<T, N>(outPose, track[lane].mJoint, component, firstChannel, values[lane]);
+            }
+        }
+    }
+#endif
+
+    template <typename T, int N, typename POSE>
+    void SampleComponent(const unsigned int* groupOffsets, T Transform::* component, SoaChannel firstChannel,
+                         const SampleContext& data, POSE& outPose)
+    {
+        const PackedTrack* tracks = data.mTracks;
+        SampleGroup<T, N, Interpolation::Constant>(tracks + groupOffsets[0], tracks + groupOffsets[1],
+                                                    component, firstChannel, data, outPose);
+#if PACKED_CLIP_SSE
+        SampleLinearGroup<T, N>(tracks + groupOffsets[1], tracks + groupOffsets[2], component, firstChannel, data,
+                                outPose);
+#else
+        SampleGroup<T, N, Interpolation::Linear>(tracks + groupOffsets[1], tracks + groupOffsets[2],
+                                                  component, firstChannel, data, outPose);
+#endif
+        SampleGroup<T, N, Interpolation::Cubic>(tracks + groupOffsets[2], tracks + groupOffsets[3],
+                                                 component, firstChannel, data, outPose);
+    }
+} // End of PackedClipHelpers
+
+PackedClip::PackedClip()
+{
+    mAllocation = nullptr;
+    mTimes = nullptr;
+    mValues = nullptr;
+    mInTangents = nullptr;
+    mOutTangents = nullptr;
+    mNumTimes = 0;
+    mNumValues = 0;
+    mNumTangents = 0;
+    memset(mGroupOffsets, 0, sizeof(mGroupOffsets));
+    mLookupRate = 0.0f;
+    mName = "None";
+    mStartTime = 0.0f;
+    mEndTime = 0.0f;
+    mLooping = true;
+}
+
+PackedClip::PackedClip(const PackedClip& other)
+{
+    mAllocation = nullptr;
+    *this = other;
+}
+
+PackedClip& PackedClip::operator=(const PackedClip& other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    Allocate(other.mNumTimes, other.mNumValues, other.mNumTangents);
+    if (mAllocation != nullptr)
+    {
+        // The sections are laid out back to back, so one copy moves all of them
+        memcpy(mTimes, other.mTimes, sizeof(float) * (mNumTimes + mNumValues + 2 * mNumTangents));
+    }
+    mTracks = other.mTracks;
+    mTimeRuns = other.mTimeRuns;
+    mTrackRuns = other.mTrackRuns;
+    mLookupTable = other.mLookupTable;
+    mLookupRate = other.mLookupRate;
+    memcpy(mGroupOffsets, other.mGroupOffsets, sizeof(mGroupOffsets));
+    mName = other.mName;
+    mStartTime = other.mStartTime;
+    mEndTime = other.mEndTime;
+    mLooping = other.mLooping;
+    return *this;
+}
+
+PackedClip::~PackedClip()
+{
+    Free();
+}
+
+void PackedClip::Free()
+{
+    delete[] mAllocation;
+    mAllocation = nullptr;
+    mTimes = nullptr;
+    mValues = nullptr;
+    mInTangents = nullptr;
+    mOutTangents = nullptr;
+    mNumTimes = 0;
+    mNumValues = 0;
+    mNumTangents = 0;
+}
+
+void PackedClip::Allocate(unsigned int numTimes, unsigned int numValues, unsigned int numTangents)
+{
+    Free();
+    const unsigned int numFloats = numTimes + numValues + 2 * numTangents;
+    if (numFloats == 0)
+    {
+        return;
+    }
+
+    mAllocation = new unsigned char[numFloats * sizeof(float) + 15];
+    const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(mAllocation) + 15) & ~static_cast<std::uintptr_t>(15);
+
+    mNumTimes = numTimes;
+    mNumValues = numValues;
+    mNumTangents = numTangents;
+    mTimes = reinterpret_cast<float*>(aligned);
+    mValues = mTimes + numTimes;
+    mInTangents = mValues + numValues;
+    mOutTangents = mInTangents + numTangents;
+    memset(mTimes, 0, numFloats * sizeof(float));
+}
+
+void PackedClip::Set(Clip& clip)
+{
+    mTracks.clear();
+    const unsigned int numTransformTracks = clip.Size();
+    for (unsigned int i = 0; i < numTransformTracks; ++i)
+    {
+        const unsigned int joint = clip.GetIdAtIndex(i);
+        TransformTrack& track = clip[joint];
+        PackedClipHelpers::AddTrack(mTracks, track.GetPositionTrack(), joint, PackedComponent::Position);
+        PackedClipHelpers::AddTrack(mTracks, track.GetRotationTrack(), joint, PackedComponent::Rotation);
+        PackedClipHelpers::AddTrack(mTracks, track.GetScaleTrack(), joint, PackedComponent::Scale);
+    }
+
+    std::sort(mTracks.begin(), mTracks.end(), [](const PackedTrack& a, const PackedTrack& b)
+    {
+        const unsigned int groupA = PackedClipHelpers::GroupIndex(a.mComponent, a.mInterpolation);
+        const unsigned int groupB = PackedClipHelpers::GroupIndex(b.mComponent, b.mInterpolation);
+        if (groupA != groupB)
+        {
+            return groupA < groupB;
+        }
+        return a.mJoint < b.mJoint;
+    });
+
+    std::vector<float> timeSection;
+    std::vector<PackedTimeRun> timeRuns;
+    std::vector<float> keyTimes;
+    unsigned int numValues = 0;
+    unsigned int numTangents = 0;
+    const unsigned int numTracks = static_cast<unsigned>(mTracks.size());
+    memset(mGroupOffsets, 0, sizeof(mGroupOffsets));
+    for (unsigned int i = 0; i < numTracks; ++i)
+    {
+        PackedTrack& packed = mTracks[i];
+        const unsigned int numFloats = packed.mNumFrames * PackedClipHelpers::ComponentSize(packed.mComponent);
+        PackedClipHelpers::GetKeyTimes(clip, packed, keyTimes);
+        packed.mTimeOffset = PackedClipHelpers::FindOrAddTimes(timeSection, timeRuns, keyTimes);
+        packed.mValueOffset = numValues;
+        packed.mTangentOffset = numTangents;
+        numValues += PackedClipHelpers::AlignFloats(numFloats);
+        if (packed.mInterpolation == Interpolation::Cubic)
+        {
+            numTangents += PackedClipHelpers::AlignFloats(numFloats);
+        }
+        mGroupOffsets[PackedClipHelpers::GroupIndex(packed.mComponent, packed.mInterpolation) + 1] = i + 1;
+    }
+    // Empty groups start where the previous one ended
+    for (unsigned int i = 1; i <= PACKED_CLIP_NUM_GROUPS; ++i)
+    {
+        if (mGroupOffsets[i] < mGroupOffsets[i - 1])
+        {
+            mGroupOffsets[i] = mGroupOffsets[i - 1];
+        }
+    }
+    Allocate(static_cast<unsigned>(timeSection.size()), numValues, numTangents);
+    if (!timeSection.empty())
+    {
+        memcpy(mTimes, timeSection.data(), timeSection.size() * sizeof(float));
+    }
+
+    for (unsigned int i = 0; i < numTracks; ++i)
+    {
+        const PackedTrack& packed = mTracks[i];
+        TransformTrack& track = clip[packed.mJoint];
+        if (packed.mComponent == PackedComponent::Position)
+        {
+            PackedClipHelpers::CopyFrames(track.GetPositionTrack(), packed, mValues, mInTangents, mOutTangents);
+        }
+        else if (packed.mComponent == PackedComponent::Rotation)
+        {
+            PackedClipHelpers::CopyFrames(track.GetRotationTrack(), packed, mValues, mInTangents, mOutTangents);
+        }
+        else
+        {
+            PackedClipHelpers::CopyFrames(track.GetScaleTrack(), packed, mValues, mInTangents, mOutTangents);
+        }
+    }
+
+    UpdateTimeRuns();
+
+    mName = clip.GetName();
+    mStartTime = clip.GetStartTime();
+    mEndTime = clip.GetEndTime();
+    mLooping = clip.GetLooping();
+}
+
+void PackedClip::SetView(const std::vector<PackedTrack>& tracks, const unsigned int* groupOffsets, const float* data,
+                         unsigned int numTimes, unsigned int numValues, unsigned int numTangents)
+{
+    Free();
+    mTracks = tracks;
+    memcpy(mGroupOffsets, groupOffsets, sizeof(mGroupOffsets));
+
+    // Sampling only reads the sections, a view never writes through these
+    mNumTimes = numTimes;
+    mNumValues = numValues;
+    mNumTangents = numTangents;
+    mTimes = const_cast<float*>(data);
+    mValues = mTimes + numTimes;
+    mInTangents = mValues + numValues;
+    mOutTangents = mInTangents + numTangents;
+
+    UpdateTimeRuns();
+}
+
+void PackedClip::UpdateTimeRuns()
+{
+    // Tracks keyed on the same times point at the same offset, cooked data doesn't store the runs
+    mTimeRuns.clear();
+    const unsigned int numTracks = static_cast<unsigned>(mTracks.size());
+    mTrackRuns.resize(numTracks);
+    for (unsigned int i = 0; i < numTracks; ++i)
+    {
+        const PackedTrack& track = mTracks[i];
+        unsigned int run = 0;
+        const unsigned int numRuns = static_cast<unsigned>(mTimeRuns.size());
+        while (run < numRuns &&
+               (mTimeRuns[run].mOffset != track.mTimeOffset || mTimeRuns[run].mNumFrames != track.mNumFrames))
+        {
+            ++run;
+        }
+        if (run == numRuns)
+        {
+            PackedTimeRun newRun;
+            newRun.mOffset = track.mTimeOffset;
+            newRun.mNumFrames = track.mNumFrames;
+            newRun.mTableOffset = 0;
+            newRun.mTableSize = 0;
+            mTimeRuns.push_back(newRun);
+        }
+        mTrackRuns[i] = run;
+    }
+    UpdateIndexLookupTables(mLookupRate);
+}
+
+void PackedClip::UpdateIndexLookupTables(float sampleRate)
+{
+    mLookupRate = sampleRate;
+    mLookupTable.clear();
+    for (unsigned int i = 0, numRuns = static_cast<unsigned>(mTimeRuns.size()); i < numRuns; ++i)
+    {
+        PackedTimeRun& run = mTimeRuns[i];
+        run.mTableOffset = static_cast<unsigned>(mLookupTable.size());
+        run.mTableSize = TrackHelpers::BuildFrameLookupTable(mLookupTable, mTimes + run.mOffset, 1, run.mNumFrames,
+                                                             sampleRate);
+    }
+}
+
+float PackedClip::Sample(Pose& outPose, float time) const
+{
+    return SampleInto(outPose, time, nullptr);
+}
+
+float PackedClip::Sample(Pose& outPose, float time, PackedClipCursor& cursor) const
+{
+    return SampleInto(outPose, time, &cursor);
+}
+
+float PackedClip::Sample(SoaPose& outPose, float time) const
+{
+    return SampleInto(outPose, time, nullptr);
+}
+
+float PackedClip::Sample(SoaPose& outPose, float time, PackedClipCursor& cursor) const
+{
+    return SampleInto(outPose, time, &cursor);
+}
+
+template <typename POSE>
+float PackedClip::SampleInto(POSE& outPose, float time, PackedClipCursor* cursor) const
+{
+    if (GetDuration() == 0.0f)
+    {
+        return 0.0f;
+    }
+    time = AdjustTimeToFitRange(time);
+    if (mTracks.empty())
+    {
+        return time;
+    }
+
+    PackedClipHelpers::SampleContext data;
+    data.mTimes = mTimes;
+    data.mValues = mValues;
+    data.mInTangents = mInTangents;
+    data.mOutTangents = mOutTangents;
+    data.mTracks = &mTracks[0];
+    data.mTimeRuns = &mTimeRuns[0];
+    data.mTrackRuns = &mTrackRuns[0];
+    data.mLookupTable = mLookupTable.empty() ? nullptr : &mLookupTable[0];
+    data.mRunSamples = nullptr;
+    data.mLookupRate = mLookupRate;
+    data.mTime = time;
+    data.mLooping = mLooping;
+
+    if (cursor != nullptr)
+    {
+        // Each run is resolved once here, then every track keyed on it reads the result
+        const unsigned int numRuns = static_cast<unsigned>(mTimeRuns.size());
+        if (cursor->mRuns.size() != numRuns)
+        {
+            cursor->mRuns.assign(numRuns, TrackCursor());
+            cursor->mSamples.resize(numRuns);
+        }
+        for (unsigned int i = 0; i < numRuns; ++i)
+        {
+            cursor->mSamples[i] = PackedClipHelpers::ResolveRun(data, mTimeRuns[i], &cursor->mRuns[i]);
+        }
+        data.mRunSamples = &cursor->mSamples[0];
+    }
+
+    PackedClipHelpers::SampleComponent<Vec3, 3>(&mGroupOffsets[0], &Transform::position, SoaChannel::PositionX,
+                                                data, outPose);
+    PackedClipHelpers::SampleComponent<Quat, 4>(&mGroupOffsets[3], &Transform::rotation, SoaChannel::RotationX,
+                                                data, outPose);
+    PackedClipHelpers::SampleComponent<Vec3, 3>(&mGroupOffsets[6], &Transform::scale, SoaChannel::ScaleX,
+                                                data, outPose);
+    return time;
+}
+
+float PackedClip::AdjustTimeToFitRange(float inTime) const
+{
+    if (mLooping)
+    {
+        const float duration = mEndTime - mStartTime;
+        if (duration <= 0)
+        {
+            return 0.0f;
+        }
+
+        inTime = fmodf(inTime - mStartTime, mEndTime - mStartTime);
+        if (inTime < 0.0f)
+        {
+            inTime += mEndTime - mStartTime;
+        }
+        inTime = inTime + mStartTime;
+    }
+    else
+    {
+        if (inTime < mStartTime)
+        {
+            inTime = mStartTime;
+        }
+        if (inTime > mEndTime)
+        {
+            inTime = mEndTime;
+        }
+    }
+    return inTime;
+}
+
+unsigned int PackedClip::Size() const
+{
+    return static_cast<unsigned>(mTracks.size());
+}
+
+const PackedTrack& PackedClip::GetTrack(unsigned int index) const
+{
+    return mTracks[index];
+}
+
+const std::vector<PackedTrack>& PackedClip::GetTracks() const
+{
+    return mTracks;
+}
+
+unsigned int PackedClip::GetNumTimeRuns() const
+{
+    return static_cast<unsigned>(mTimeRuns.size());
+}
+
+const unsigned int* PackedClip::GetGroupOffsets() const
+{
+    return mGroupOffsets;
+}
+
+const float* PackedClip::GetData() const
+{
+    return mTimes;
+}
+
+unsigned int PackedClip::GetNumTimes() const
+{
+    return mNumTimes;
+}
+
+unsigned int PackedClip::GetNumValues() const
+{
+    return mNumValues;
+}
+
+unsigned int PackedClip::GetNumTangents() const
+{
+    return mNumTangents;
+}
+
+unsigned int PackedClip::GetDataSize() const
+{
+    return (mNumTimes + mNumValues + 2 * mNumTangents) * sizeof(float);
+}
+
+std::string& PackedClip::GetName()
+{
+    return mName;
+}
+
+float PackedClip::GetDuration() const
+{
+    return mEndTime - mStartTime;
+}
+
+float PackedClip::GetStartTime() const
+{
+    return mStartTime;
+}
+
+float PackedClip::GetEndTime() const
+{
+    return mEndTime;
+}
+
+void PackedClip::SetTimeRange(float startTime, float endTime)
+{
+    mStartTime = startTime;
+    mEndTime = endTime;
+}
+
+bool PackedClip::GetLooping() const
+{
+    return mLooping;
+}
+
+void PackedClip::SetLooping(bool inLooping)
+{
+    mLooping = inLooping;
+}
+
+PackedClip PackClip(Clip& input)
+{
+    PackedClip result;
+    result.Set(input);
+    return result;
+}
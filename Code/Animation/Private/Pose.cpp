@@ -1,13 +1,23 @@
 #include "Animation/Public/Pose.h"
+#include <cstring>
 
-Pose::Pose() = default;
+namespace PoseHelpers
+{
+    const unsigned char DirtyTransform = 1;
+    const unsigned char DirtyMatrix = 2;
+    const unsigned char DirtyAll = DirtyTransform | DirtyMatrix;
+} // End of PoseHelpers
+
+Pose::Pose() : mAnyDirty(0)
+{
+}
 
-Pose::Pose(unsigned int numJoints)
+Pose::Pose(unsigned int numJoints) : mAnyDirty(0)
 {
     Resize(numJoints);
 }
 
-Pose::Pose(const Pose& p)
+Pose::Pose(const Pose& p) : mAnyDirty(0)
 {
     *this = p;
 }
@@ -19,6 +29,18 @@ Pose& Pose::operator=(const Pose& p)
         return *this;
     }
 
+    const bool sameHierarchy = mParents.size() == p.mParents.size() && !mParents.empty() &&
+        memcmp(&mParents[0], &p.mParents[0], sizeof(int) * mParents.size()) == 0;
+    if (sameHierarchy)
+    {
+        // Keep the caches, only the joints that differ need recomputing
+        for (unsigned int i = 0; i < Size(); ++i)
+        {
+            SetLocalTransform(i, p.mJoints[i]);
+        }
+        return *this;
+    }
+
     if (mParents.size() != p.mParents.size())
     {
         mParents.resize(p.mParents.size());
@@ -39,6 +61,11 @@ Pose& Pose::operator=(const Pose& p)
                sizeof(Transform) * mJoints.size());
     }
 
+    mDirty = p.mDirty;
+    mGlobals = p.mGlobals;
+    mPalette = p.mPalette;
+    mAnyDirty = p.mAnyDirty;
+
     return *this;
 }
 
@@ -46,6 +73,10 @@ void Pose::Resize(unsigned int size)
 {
     mParents.resize(size);
     mJoints.resize(size);
+    mDirty.resize(size);
+    mGlobals.resize(size);
+    mPalette.resize(size);
+    MarkAllDirty();
 }
 
 unsigned int Pose::Size() const
@@ -58,13 +89,40 @@ Transform Pose::GetLocalTransform(unsigned int index) const
     return mJoints[index];
 }
 
+// Raw joint array, for samplers that write many joints at once.
+// Every joint written through it has to be passed to MarkDirty.
+Transform* Pose::GetLocalTransforms()
+{
+    return mJoints.empty() ? nullptr : &mJoints[0];
+}
+
 void Pose::SetLocalTransform(unsigned int index,
                              const Transform& transform)
 {
-    mJoints[index] = transform;
+    // Samplers set every animated joint each frame, most of them to the value they already hold
+    if (memcmp(&mJoints[index], &transform, sizeof(Transform)) != 0)
+    {
+        mJoints[index] = transform;
+        MarkDirty(index);
+    }
+}
+
+void Pose::MarkDirty(unsigned int index)
+{
+    mDirty[index] = PoseHelpers::DirtyAll;
+    mAnyDirty = PoseHelpers::DirtyAll;
 }
 
-Transform Pose::GetGlobalTransform(unsigned int index) const
+void Pose::MarkAllDirty()
+{
+    for (unsigned int i = 0; i < mDirty.size(); ++i)
+    {
+        mDirty[i] = PoseHelpers::DirtyAll;
+    }
+    mAnyDirty = PoseHelpers::DirtyAll;
+}
+
+Transform Pose::WalkGlobalTransform(unsigned int index) const
 {
     Transform result = mJoints[index];
     for (int parent = mParents[index]; parent >= 0;
@@ -76,6 +134,78 @@ Transform Pose::GetGlobalTransform(unsigned int index) const
     return result;
 }
 
+void Pose::UpdateCache(unsigned char mask) const
+{
+    if ((mAnyDirty & mask) == 0)
+    {
+        return;
+    }
+
+    // Joints are loaded with every parent before its children, so one forward pass pushes
+    // the dirty flags down each changed subtree and recomputes from the parent's cached value
+    const unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const int parent = mParents[i];
+        const bool outOfOrder = parent >= static_cast<int>(i);
+        if (parent >= 0 && !outOfOrder)
+        {
+            mDirty[i] |= mDirty[parent] & mask;
+        }
+        if (outOfOrder)
+        {
+            // The parent isn't up to date yet, walk the whole chain
+            mDirty[i] |= mask;
+        }
+
+        const unsigned char dirty = mDirty[i] & mask;
+        if (dirty == 0)
+        {
+            continue;
+        }
+
+        Transform local = mJoints[i];
+        if (dirty & PoseHelpers::DirtyTransform)
+        {
+            if (outOfOrder)
+            {
+                mGlobals[i] = WalkGlobalTransform(i);
+            }
+            else
+            {
+                mGlobals[i] = parent < 0 ? local : Transform::Combine(mGlobals[parent], local);
+            }
+            ++mStats.mTransforms;
+        }
+        if (dirty & PoseHelpers::DirtyMatrix)
+        {
+            if (outOfOrder)
+            {
+                Transform t = WalkGlobalTransform(i);
+                mPalette[i] = t.ToMat4();
+            }
+            else
+            {
+                mPalette[i] = parent < 0 ? local.ToMat4() : mPalette[parent] * local.ToMat4();
+            }
+            ++mStats.mMatrices;
+        }
+    }
+
+    // Children read their parent's flag above, so they are only cleared once the pass is done
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        mDirty[i] &= ~mask;
+    }
+    mAnyDirty &= ~mask;
+}
+
+Transform Pose::GetGlobalTransform(unsigned int index) const
+{
+    UpdateCache(PoseHelpers::DirtyTransform);
+    return mGlobals[index];
+}
+
 Transform Pose::operator[](unsigned int index)
 {
     return GetGlobalTransform(index);
@@ -83,16 +213,107 @@ Transform Pose::operator[](unsigned int index)
 
 void Pose::GetMatrixPalette(std::vector<Mat4>& out) const
 {
+    UpdateCache(PoseHelpers::DirtyMatrix);
+    out = mPalette;
+}
+
+// Palette times the inverse bind pose, the matrix skinning needs for each joint
+void Pose::GetSkinPalette(const std::vector<Mat4>& invBindPose, std::vector<Mat4>& out) const
+{
+    GetMatrixPalette(out);
+    const unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        out[i] = out[i] * invBindPose[i];
+    }
+}
+
+// Only the joints a skin uses, in the skin's order
+void Pose::GetSkinPalette(const std::vector<Mat4>& invBindPose, const std::vector<unsigned int>& joints,
+                          std::vector<Mat4>& out) const
+{
+    UpdateCache(PoseHelpers::DirtyMatrix);
+    const unsigned int size = static_cast<unsigned>(joints.size());
+    if (out.size() != size)
+    {
+        out.resize(size);
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const unsigned int joint = joints[i];
+        out[i] = mPalette[joint] * invBindPose[joint];
+    }
+}
+
+// Skin palette without the bottom row, which is always (0, 0, 0, 1)
+void Pose::GetAffineSkinPalette(const std::vector<Mat4>& invBindPose, std::vector<Mat3x4>& out) const
+{
+    UpdateCache(PoseHelpers::DirtyMatrix);
     const unsigned int size = Size();
     if (out.size() != size)
     {
         out.resize(size);
     }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        out[i] = Mat3x4(mPalette[i] * invBindPose[i]);
+    }
+}
 
+void Pose::GetAffineSkinPalette(const std::vector<Mat4>& invBindPose, const std::vector<unsigned int>& joints,
+                                std::vector<Mat3x4>& out) const
+{
+    UpdateCache(PoseHelpers::DirtyMatrix);
+    const unsigned int size = static_cast<unsigned>(joints.size());
+    if (out.size() != size)
+    {
+        out.resize(size);
+    }
     for (unsigned int i = 0; i < size; ++i)
     {
-        Transform t = GetGlobalTransform(i);
-        out[i] = t.ToMat4();
+        const unsigned int joint = joints[i];
+        out[i] = Mat3x4(mPalette[joint] * invBindPose[joint]);
+    }
+}
+
+// World transforms come from the cache, scale is dropped
+void Pose::GetDualQuatPalette(std::vector<DualQuat>& out) const
+{
+    UpdateCache(PoseHelpers::DirtyTransform);
+    const unsigned int size = Size();
+    if (out.size() != size)
+    {
+        out.resize(size);
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        out[i] = DualQuat::FromTransform(mGlobals[i]);
+    }
+}
+
+void Pose::GetDualQuatSkinPalette(const std::vector<DualQuat>& invBindPose, std::vector<DualQuat>& out) const
+{
+    GetDualQuatPalette(out);
+    const unsigned int size = Size();
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        out[i] = invBindPose[i] * out[i];
+    }
+}
+
+void Pose::GetDualQuatSkinPalette(const std::vector<DualQuat>& invBindPose, const std::vector<unsigned int>& joints,
+                                  std::vector<DualQuat>& out) const
+{
+    UpdateCache(PoseHelpers::DirtyTransform);
+    const unsigned int size = static_cast<unsigned>(joints.size());
+    if (out.size() != size)
+    {
+        out.resize(size);
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const unsigned int joint = joints[i];
+        out[i] = invBindPose[joint] * DualQuat::FromTransform(mGlobals[joint]);
     }
 }
 
@@ -104,6 +325,17 @@ int Pose::GetParent(unsigned int index) const
 void Pose::SetParent(unsigned int index, int parent)
 {
     mParents[index] = parent;
+    MarkDirty(index);
+}
+
+PoseCacheStats Pose::GetCacheStats() const
+{
+    return mStats;
+}
+
+void Pose::ResetCacheStats()
+{
+    mStats = PoseCacheStats();
 }
 
 bool Pose::operator==(const Pose& other)
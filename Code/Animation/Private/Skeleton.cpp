@@ -19,11 +19,14 @@ void Skeleton::UpdateInverseBindPose()
 {
     unsigned int size = mBindPose.Size();
     mInvBindPose.resize(size);
+    mInvBindDualQuats.resize(size);
 
     for (unsigned int i = 0; i < size; ++i)
     {
         Transform world = mBindPose.GetGlobalTransform(i);
-        mInvBindPose[i] = (world).Inverse().ToMat4();
+        Transform inverse = world.Inverse();
+        mInvBindPose[i] = inverse.ToMat4();
+        mInvBindDualQuats[i] = DualQuat::FromTransform(inverse);
     }
 }
 
@@ -42,6 +45,43 @@ std::vector<Mat4>& Skeleton::GetInvBindPose()
     return mInvBindPose;
 }
 
+void Skeleton::GetSkinPalette(const Pose& pose, std::vector<Mat4>& out) const
+{
+    pose.GetSkinPalette(mInvBindPose, out);
+}
+
+void Skeleton::GetSkinPalette(const Pose& pose, const std::vector<unsigned int>& joints, std::vector<Mat4>& out) const
+{
+    pose.GetSkinPalette(mInvBindPose, joints, out);
+}
+
+void Skeleton::GetAffineSkinPalette(const Pose& pose, std::vector<Mat3x4>& out) const
+{
+    pose.GetAffineSkinPalette(mInvBindPose, out);
+}
+
+void Skeleton::GetAffineSkinPalette(const Pose& pose, const std::vector<unsigned int>& joints,
+                                    std::vector<Mat3x4>& out) const
+{
+    pose.GetAffineSkinPalette(mInvBindPose, joints, out);
+}
+
+std::vector<DualQuat>& Skeleton::GetInvBindDualQuats()
+{
+    return mInvBindDualQuats;
+}
+
+void Skeleton::GetDualQuatSkinPalette(const Pose& pose, std::vector<DualQuat>& out) const
+{
+    pose.GetDualQuatSkinPalette(mInvBindDualQuats, out);
+}
+
+void Skeleton::GetDualQuatSkinPalette(const Pose& pose, const std::vector<unsigned int>& joints,
+                                      std::vector<DualQuat>& out) const
+{
+    pose.GetDualQuatSkinPalette(mInvBindDualQuats, joints, out);
+}
+
 std::vector<std::string>& Skeleton::GetJointNames()
 {
     return mJointNames;
@@ -0,0 +1,407 @@
+#include "Animation/Public/SoaPose.h"
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+namespace SoaPoseHelpers
+{
+    const int NumChannels = static_cast<int>(SoaChannel::Count);
+
+    // Identity transform, per channel
+    const float kIdentity[NumChannels] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+
+    inline unsigned int AlignJoints(unsigned int count)
+    {
+        return (count + 3) & ~3u;
+    }
+
+#if SOA_POSE_SSE
+    // Same sums in the same order as operator*(const Mat4&, const Mat4&), out may alias a or b
+    inline void MultiplyMat4(const float* a, const float* b, float* out)
+    {
+        const __m128 c0 = _mm_loadu_ps(a + 0);
+        const __m128 c1 = _mm_loadu_ps(a + 4);
+        const __m128 c2 = _mm_loadu_ps(a + 8);
+        const __m128 c3 = _mm_loadu_ps(a + 12);
+        for (int column = 0; column < 4; ++column)
+        {
+            const float* bColumn = b + column * 4;
+            __m128 r = _mm_mul_ps(c0, _mm_set1_ps(bColumn[0]));
+            r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(bColumn[1])));
+            r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(bColumn[2])));
+            r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(bColumn[3])));
+            _mm_storeu_ps(out + column * 4, r);
+        }
+    }
+
+    // Transform::ToMat4 for four joints, written to outMatrices[0..count)
+    inline void LocalMatrices(const float* const* channels, unsigned int first, unsigned int count, Mat4* outMatrices)
+    {
+        const __m128 px = _mm_load_ps(channels[0] + first);
+        const __m128 py = _mm_load_ps(channels[1] + first);
+        const __m128 pz = _mm_load_ps(channels[2] + first);
+        const __m128 x = _mm_load_ps(channels[3] + first);
+        const __m128 y = _mm_load_ps(channels[4] + first);
+        const __m128 z = _mm_load_ps(channels[5] + first);
+        const __m128 w = _mm_load_ps(channels[6] + first);
+        const __m128 sx = _mm_load_ps(channels[7] + first);
+        const __m128 sy = _mm_load_ps(channels[8] + first);
+        const __m128 sz = _mm_load_ps(channels[9] + first);
+
+        // Basis vectors as rotation * axis, expanded from operator*(const Quat&, const Vec3&)
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 d = _mm_sub_ps(_mm_mul_ps(w, w),
+                                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        const __m128 x2 = _mm_mul_ps(x, two);
+        const __m128 y2 = _mm_mul_ps(y, two);
+        const __m128 z2 = _mm_mul_ps(z, two);
+        const __m128 wx = _mm_mul_ps(w, x2);
+        const __m128 wy = _mm_mul_ps(w, y2);
+        const __m128 wz = _mm_mul_ps(w, z2);
+        const __m128 xy = _mm_mul_ps(x2, y);
+        const __m128 xz = _mm_mul_ps(x2, z);
+        const __m128 yz = _mm_mul_ps(y2, z);
+
+        __m128 c0x = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(x2, x), d), sx);
+        __m128 c0y = _mm_mul_ps(_mm_add_ps(xy, wz), sx);
+        __m128 c0z = _mm_mul_ps(_mm_sub_ps(xz, wy), sx);
+        __m128 c1x = _mm_mul_ps(_mm_sub_ps(xy, wz), sy);
+        __m128 c1y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(y2, y), d), sy);
+        __m128 c1z = _mm_mul_ps(_mm_add_ps(yz, wx), sy);
+        __m128 c2x = _mm_mul_ps(_mm_add_ps(xz, wy), sz);
+        __m128 c2y = _mm_mul_ps(_mm_sub_ps(yz, wx), sz);
+        __m128 c2z = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(z2, z), d), sz);
+
+        __m128 zero0 = _mm_setzero_ps();
+        __m128 zero1 = _mm_setzero_ps();
+        __m128 zero2 = _mm_setzero_ps();
+        __m128 c3x = px;
+        __m128 c3y = py;
+        __m128 c3z = pz;
+        __m128 one = _mm_set1_ps(1.0f);
+        _MM_TRANSPOSE4_PS(c0x, c0y, c0z, zero0);
+        _MM_TRANSPOSE4_PS(c1x, c1y, c1z, zero1);
+        _MM_TRANSPOSE4_PS(c2x, c2y, c2z, zero2);
+        _MM_TRANSPOSE4_PS(c3x, c3y, c3z, one);
+
+        const __m128 columns[4][4] = {
+            { c0x, c1x, c2x, c3x },
+            { c0y, c1y, c2y, c3y },
+            { c0z, c1z, c2z, c3z },
+            { zero0, zero1, zero2, one }
+        };
+        for (unsigned int lane = 0; lane < count; ++lane)
+        {
+            for (int column = 0; column < 4; ++column)
+            {
+                _mm_storeu_ps(outMatrices[lane].v + column * 4, columns[lane][column]);
+            }
+        }
+    }
+
+    // Quat::Normalized on four lanes, a near zero quaternion becomes the identity
+    inline void NormalizeLanes(__m128& x, __m128& y, __m128& z, __m128& w)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                                   _mm_mul_ps(z, z)), _mm_mul_ps(w, w));
+        const __m128 degenerate = _mm_cmplt_ps(lenSq, _mm_set1_ps(QUAT_EPSILON));
+        const __m128 invLen = _mm_div_ps(one, _mm_sqrt_ps(lenSq));
+        x = _mm_andnot_ps(degenerate, _mm_mul_ps(x, invLen));
+        y = _mm_andnot_ps(degenerate, _mm_mul_ps(y, invLen));
+        z = _mm_andnot_ps(degenerate, _mm_mul_ps(z, invLen));
+        w = _mm_or_ps(_mm_andnot_ps(degenerate, _mm_mul_ps(w, invLen)), _mm_and_ps(degenerate, one));
+    }
+#endif
+} // End of SoaPoseHelpers
+
+SoaPose::SoaPose()
+{
+    mAllocation = nullptr;
+    memset(mChannels, 0, sizeof(mChannels));
+    mSize = 0;
+    mCapacity = 0;
+}
+
+SoaPose::SoaPose(unsigned int numJoints) : SoaPose()
+{
+    Resize(numJoints);
+}
+
+SoaPose::SoaPose(const SoaPose& other) : SoaPose()
+{
+    *this = other;
+}
+
+SoaPose& SoaPose::operator=(const SoaPose& other)
+{
+    if (&other == this)
+    {
+        return *this;
+    }
+
+    if (mCapacity != other.mCapacity)
+    {
+        Allocate(other.mCapacity);
+    }
+    if (mAllocation != nullptr)
+    {
+        // The channels are laid out back to back, so one copy moves all of them
+        memcpy(mChannels[0], other.mChannels[0], sizeof(float) * mCapacity * SoaPoseHelpers::NumChannels);
+    }
+    mSize = other.mSize;
+    mParents = other.mParents;
+    return *this;
+}
+
+SoaPose::~SoaPose()
+{
+    Free();
+}
+
+void SoaPose::Free()
+{
+    delete[] mAllocation;
+    mAllocation = nullptr;
+    memset(mChannels, 0, sizeof(mChannels));
+    mCapacity = 0;
+}
+
+void SoaPose::Allocate(unsigned int capacity)
+{
+    Free();
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    mAllocation = new unsigned char[capacity * SoaPoseHelpers::NumChannels * sizeof(float) + 15];
+    const std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(mAllocation) + 15) & ~static_cast<std::uintptr_t>(15);
+    mCapacity = capacity;
+    for (int channel = 0; channel < SoaPoseHelpers::NumChannels; ++channel)
+    {
+        mChannels[channel] = reinterpret_cast<float*>(aligned) + channel * capacity;
+    }
+}
+
+void SoaPose::Resize(unsigned int size)
+{
+    const unsigned int capacity = SoaPoseHelpers::AlignJoints(size);
+    if (capacity != mCapacity)
+    {
+        SoaPose old(*this);
+        Allocate(capacity);
+        const unsigned int kept = old.mSize < size ? old.mSize : size;
+        for (int channel = 0; channel < SoaPoseHelpers::NumChannels && kept > 0; ++channel)
+        {
+            memcpy(mChannels[channel], old.mChannels[channel], sizeof(float) * kept);
+        }
+    }
+
+    // New joints and padding start as the identity
+    for (int channel = 0; channel < SoaPoseHelpers::NumChannels; ++channel)
+    {
+        for (unsigned int i = mSize < size ? mSize : size; i < mCapacity; ++i)
+        {
+            mChannels[channel][i] = SoaPoseHelpers::kIdentity[channel];
+        }
+    }
+    mSize = size;
+    mParents.resize(size, -1);
+}
+
+unsigned int SoaPose::Size() const
+{
+    return mSize;
+}
+
+float* SoaPose::GetChannel(SoaChannel channel)
+{
+    return mChannels[static_cast<int>(channel)];
+}
+
+const float* SoaPose::GetChannel(SoaChannel channel) const
+{
+    return mChannels[static_cast<int>(channel)];
+}
+
+Transform SoaPose::GetLocalTransform(unsigned int index) const
+{
+    return Transform(
+        Vec3(mChannels[0][index], mChannels[1][index], mChannels[2][index]),
+        Quat(mChannels[3][index], mChannels[4][index], mChannels[5][index], mChannels[6][index]),
+        Vec3(mChannels[7][index], mChannels[8][index], mChannels[9][index]));
+}
+
+void SoaPose::SetLocalTransform(unsigned int index, const Transform& transform)
+{
+    mChannels[0][index] = transform.position.x;
+    mChannels[1][index] = transform.position.y;
+    mChannels[2][index] = transform.position.z;
+    mChannels[3][index] = transform.rotation.x;
+    mChannels[4][index] = transform.rotation.y;
+    mChannels[5][index] = transform.rotation.z;
+    mChannels[6][index] = transform.rotation.w;
+    mChannels[7][index] = transform.scale.x;
+    mChannels[8][index] = transform.scale.y;
+    mChannels[9][index] = transform.scale.z;
+}
+
+Transform SoaPose::GetGlobalTransform(unsigned int index) const
+{
+    Transform result = GetLocalTransform(index);
+    for (int parent = mParents[index]; parent >= 0; parent = mParents[parent])
+    {
+        result = Transform::Combine(GetLocalTransform(parent), result);
+    }
+    return result;
+}
+
+void SoaPose::GetMatrixPalette(std::vector<Mat4>& out) const
+{
+    if (out.size() != mSize)
+    {
+        out.resize(mSize);
+    }
+
+    // Local matrices first, they don't depend on each other
+#if SOA_POSE_SSE
+    for (unsigned int first = 0; first < mSize; first += 4)
+    {
+        const unsigned int count = mSize - first < 4 ? mSize - first : 4;
+        SoaPoseHelpers::LocalMatrices(mChannels, first, count, &out[first]);
+    }
+#else
+    for (unsigned int i = 0; i < mSize; ++i)
+    {
+        out[i] = GetLocalTransform(i).ToMat4();
+    }
+#endif
+
+    // Then one pass down the hierarchy, each parent is already in model space
+    for (unsigned int i = 0; i < mSize; ++i)
+    {
+        const int parent = mParents[i];
+        if (parent < 0)
+        {
+            continue;
+        }
+        if (parent >= static_cast<int>(i))
+        {
+            // Out of order hierarchy, walk the whole chain
+            out[i] = GetGlobalTransform(i).ToMat4();
+            continue;
+        }
+#if SOA_POSE_SSE
+        SoaPoseHelpers::MultiplyMat4(out[parent].v, out[i].v, out[i].v);
+#else
+        out[i] = out[parent] * out[i];
+#endif
+    }
+}
+
+void SoaPose::GetSkinPalette(const std::vector<Mat4>& invBindPose, std::vector<Mat4>& out) const
+{
+    GetMatrixPalette(out);
+    for (unsigned int i = 0; i < mSize; ++i)
+    {
+#if SOA_POSE_SSE
+        SoaPoseHelpers::MultiplyMat4(out[i].v, invBindPose[i].v, out[i].v);
+#else
+        out[i] = out[i] * invBindPose[i];
+#endif
+    }
+}
+
+// Transform::Mix for every joint
+void SoaPose::Blend(const SoaPose& a, const SoaPose& b, float t)
+{
+    const unsigned int size = a.mSize < b.mSize ? a.mSize : b.mSize;
+    if (mSize != size)
+    {
+        Resize(size);
+    }
+
+#if SOA_POSE_SSE
+    const __m128 blend = _mm_set1_ps(t);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    for (unsigned int first = 0; first < size; first += 4)
+    {
+        // Positions and scales, Vec3::Lerp
+        const int lerpChannels[6] = { 0, 1, 2, 7, 8, 9 };
+        for (int c = 0; c < 6; ++c)
+        {
+            const int channel = lerpChannels[c];
+            const __m128 start = _mm_load_ps(a.mChannels[channel] + first);
+            const __m128 end = _mm_load_ps(b.mChannels[channel] + first);
+            _mm_store_ps(mChannels[channel] + first, _mm_add_ps(start, _mm_mul_ps(_mm_sub_ps(end, start), blend)));
+        }
+
+        // Rotations, neighborhood then Quat::Nlerp
+        __m128 from[4];
+        __m128 to[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            from[c] = _mm_load_ps(a.mChannels[3 + c] + first);
+            to[c] = _mm_load_ps(b.mChannels[3 + c] + first);
+        }
+        const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(from[0], to[0]), _mm_mul_ps(from[1], to[1])),
+                                                 _mm_mul_ps(from[2], to[2])), _mm_mul_ps(from[3], to[3]));
+        const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit);
+        __m128 r[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            const __m128 end = _mm_xor_ps(to[c], flip);
+            r[c] = _mm_add_ps(from[c], _mm_mul_ps(_mm_sub_ps(end, from[c]), blend));
+        }
+        SoaPoseHelpers::NormalizeLanes(r[0], r[1], r[2], r[3]);
+        for (int c = 0; c < 4; ++c)
+        {
+            _mm_store_ps(mChannels[3 + c] + first, r[c]);
+        }
+    }
+#else
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        SetLocalTransform(i, Transform::Mix(a.GetLocalTransform(i), b.GetLocalTransform(i), t));
+    }
+#endif
+}
+
+int SoaPose::GetParent(unsigned int index) const
+{
+    return mParents[index];
+}
+
+void SoaPose::SetParent(unsigned int index, int parent)
+{
+    mParents[index] = parent;
+}
+
+void SoaPose::Set(const Pose& pose)
+{
+    const unsigned int size = pose.Size();
+    if (mSize != size)
+    {
+        Resize(size);
+    }
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        SetLocalTransform(i, pose.GetLocalTransform(i));
+        mParents[i] = pose.GetParent(i);
+    }
+}
+
+void SoaPose::Get(Pose& outPose) const
+{
+    if (outPose.Size() != mSize)
+    {
+        outPose.Resize(mSize);
+    }
+    for (unsigned int i = 0; i < mSize; ++i)
+    {
+        outPose.SetLocalTransform(i, GetLocalTransform(i));
+        outPose.SetParent(i, mParents[i]);
+    }
+}
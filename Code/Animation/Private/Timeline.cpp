@@ -0,0 +1,70 @@
+#include "Animation/Public/Timeline.h"
+#include "Animation/Public/TrackHelpers.h"
+
+Timeline::Timeline() = default;
+
+void Timeline::Resize(unsigned int size)
+{
+    mTimes.resize(size);
+}
+
+unsigned int Timeline::Size() const
+{
+    return static_cast<unsigned>(mTimes.size());
+}
+
+float& Timeline::operator[](unsigned int index)
+{
+    return mTimes[index];
+}
+
+float Timeline::operator[](unsigned int index) const
+{
+    return mTimes[index];
+}
+
+TimelineSample Timeline::Resolve(float time, bool looping) const
+{
+    const float trackTime = AdjustTimeToFitTimeline(time, looping);
+    return MakeSample(FrameIndexBinary(trackTime), trackTime);
+}
+
+TimelineSample Timeline::Resolve(float time, bool looping, TrackCursor& cursor) const
+{
+    const float trackTime = AdjustTimeToFitTimeline(time, looping);
+    return MakeSample(FrameIndex(trackTime, cursor), trackTime);
+}
+
+TimelineSample Timeline::MakeSample(int frame, float trackTime) const
+{
+    TimelineSample result;
+    result.mFrame = frame;
+    result.mT = 0.0f;
+
+    // Tracks check the delta themselves, a zero length segment samples to a default value
+    const float frameDelta = mTimes[frame + 1] - mTimes[frame];
+    if (frameDelta > 0.0f)
+    {
+        result.mT = (trackTime - mTimes[frame]) / frameDelta;
+    }
+    return result;
+}
+
+float Timeline::AdjustTimeToFitTimeline(float time, bool looping) const
+{
+    if (mTimes.empty())
+    {
+        return 0.0f;
+    }
+    return TrackHelpers::AdjustTimeToFitTimes(&mTimes[0], 1, static_cast<unsigned>(mTimes.size()), time, looping);
+}
+
+int Timeline::FrameIndexBinary(float trackTime) const
+{
+    return TrackHelpers::FrameIndexBinary(&mTimes[0], 1, static_cast<unsigned>(mTimes.size()), trackTime);
+}
+
+int Timeline::FrameIndex(float trackTime, TrackCursor& cursor) const
+{
+    return TrackHelpers::FrameIndexFromCursor(&mTimes[0], 1, static_cast<unsigned>(mTimes.size()), trackTime, cursor);
+}
@@ -1,96 +1,119 @@
 #include "Animation/Public/Track.h"
+#include "Animation/Public/TrackHelpers.h"
 
 template Track<float, 1>;
 template Track<Vec3, 3>;
 template Track<Quat, 4>;
 
-namespace TrackHelpers
+template <typename T, int N>
+Track<T, N>::Track()
 {
-    inline float Interpolate(float a, float b, float t)
-    {
-        return a + (b - a) * t;
-    }
+    mInterpolation = Interpolation::Linear;
+}
+
 
-    inline Vec3 Interpolate(const Vec3& a, const Vec3& b, float t)
+template <typename T, int N>
+float Track<T, N>::GetStartTime()
+{
+    if (mFrames.size() == 0)
     {
-        return Vec3::Lerp(a, b, t);
+        return 0.0f;
     }
+    return mFrames[0].mTime;
+}
 
-    inline Quat Interpolate(const Quat& a, const Quat& b, float t)
+template <typename T, int N>
+float Track<T, N>::GetEndTime()
+{
+    if (mFrames.size() == 0)
     {
-        Quat result = Quat::Mix(a, b, t);
-        if (Quat::Dot(a, b) < 0)
-        {
-            // Neighborhood
-            result = Quat::Mix(a, -b, t);
-        }
-        return result.Normalized(); //NLerp, not slerp
+        return 0.0f;
     }
+    return mFrames[mFrames.size() - 1].mTime;
+}
 
-    // Hermite helpers
-    inline float AdjustHermiteResult(float f)
+template <typename T, int N>
+T Track<T, N>::Sample(float time, bool looping)
+{
+    if (mFrames.size() == 1)
     {
-        return f;
+        // Single key tracks hold a constant value
+        return Cast(&mFrames[0].mValue[0]);
     }
-
-    inline Vec3 AdjustHermiteResult(const Vec3& v)
+    if (mInterpolation == Interpolation::Constant)
     {
-        return v;
+        return SampleConstant(time, looping);
     }
-
-    inline Quat AdjustHermiteResult(const Quat& q)
+    if (mInterpolation == Interpolation::Linear)
     {
-        return q.Normalized();
+        return SampleLinear(time, looping);
     }
+    return SampleCubic(time, looping);
+}
 
-    inline void Neighborhood(const float& a, float& b)
+template <typename T, int N>
+T Track<T, N>::Sample(float time, bool looping, TrackCursor& cursor)
+{
+    if (mFrames.size() <= 1)
     {
+        return mFrames.empty() ? T() : Cast(&mFrames[0].mValue[0]);
     }
+    // Wrap or clamp once, the cursor lookup and the interpolation share the result
+    float trackTime = AdjustTimeToFitTrack(time, looping);
+    int frame = FrameIndex(trackTime, cursor);
 
-    inline void Neighborhood(const Vec3& a, Vec3& b)
+    if (mInterpolation == Interpolation::Constant)
     {
+        return SampleConstant(frame);
     }
-
-    inline void Neighborhood(const Quat& a, Quat& b)
+    if (mInterpolation == Interpolation::Linear)
     {
-        if (Quat::Dot(a, b) < 0)
-        {
-            b = -b;
-        }
+        return SampleLinear(frame, trackTime);
     }
-}; // End Track Helpers namespace
-
-template <typename T, int N>
-Track<T, N>::Track()
-{
-    mInterpolation = Interpolation::Linear;
+    return SampleCubic(frame, trackTime);
 }
 
-
 template <typename T, int N>
-float Track<T, N>::GetStartTime()
+T Track<T, N>::Sample(const TimelineSample& sample)
 {
-    return mFrames[0].mTime;
-}
-
-template <typename T, int N>
-float Track<T, N>::GetEndTime()
-{
-    return mFrames[mFrames.size() - 1].mTime;
-}
+    if (mFrames.size() <= 1)
+    {
+        return mFrames.empty() ? T() : Cast(&mFrames[0].mValue[0]);
+    }
 
-template <typename T, int N>
-T Track<T, N>::Sample(float time, bool looping)
-{
+    const int thisFrame = sample.mFrame;
     if (mInterpolation == Interpolation::Constant)
     {
-        return SampleConstant(time, looping);
+        return Cast(&mFrames[thisFrame].mValue[0]);
     }
+
+    const int nextFrame = thisFrame + 1;
+    const float frameDelta = mFrames[nextFrame].mTime - mFrames[thisFrame].mTime;
+    if (frameDelta <= 0.0f)
+    {
+        return T();
+    }
+
+    T point1 = Cast(&mFrames[thisFrame].mValue[0]);
+    T point2 = Cast(&mFrames[nextFrame].mValue[0]);
     if (mInterpolation == Interpolation::Linear)
     {
-        return SampleLinear(time, looping);
+        return TrackHelpers::Interpolate(point1, point2, sample.mT);
     }
-    return SampleCubic(time, looping);
+
+    T slope1;
+    memcpy(&slope1, mFrames[thisFrame].mOut, N * sizeof(float));
+    slope1 = slope1 * frameDelta;
+    T slope2;
+    memcpy(&slope2, mFrames[nextFrame].mIn, N * sizeof(float));
+    slope2 = slope2 * frameDelta;
+    return Hermite(sample.mT, point1, slope1, point2, slope2);
+}
+
+template <typename T, int N>
+float Track<T, N>::GetTime(unsigned int index)
+{
+    return mFrames[index].mTime;
 }
 
 template <typename T, int N>
@@ -124,117 +147,78 @@ void Track<T, N>::SetInterpolation(Interpolation interpolation)
 }
 
 template <typename T, int N>
-T Track<T, N>::Hermite(float t, const T& p1, const T& s1, const T& _p2, const T& s2)
+T Track<T, N>::Hermite(float t, const T& p1, const T& s1, const T& p2, const T& s2)
 {
-    float tt = t * t;
-    float ttt = tt * t;
-
-    T p2 = _p2;
-    TrackHelpers::Neighborhood(p1, p2);
-
-    float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
-    float h2 = -2.0f * ttt + 3.0f * tt;
-    float h3 = ttt - 2.0f * tt + t;
-    float h4 = ttt - tt;
-
-    T result = p1 * h1 + p2 * h2 + s1 * h3 + s2 * h4;
-    return TrackHelpers::AdjustHermiteResult(result);
+    return TrackHelpers::Hermite(t, p1, s1, p2, s2);
 }
 
 template <typename T, int N>
 int Track<T, N>::FrameIndex(float time, bool looping)
 {
-    unsigned int size = static_cast<unsigned>(mFrames.size());
-    if (size <= 1)
+    if (mFrames.size() <= 1)
     {
         return -1;
     }
-    if (looping)
-    {
-        const float startTime = mFrames[0].mTime;
-        const float endTime = mFrames[size - 1].mTime;
-        float duration = endTime - startTime;
-
-        time = fmodf(time - startTime, endTime - startTime);
-        if (time < 0.0f)
-        {
-            time += endTime - startTime;
-        }
-        time = time + startTime;
-    }
-    else
-    {
-        if (time <= mFrames[0].mTime)
-        {
-            return 0;
-        }
-        if (time >= mFrames[size - 2].mTime)
-        {
-            return static_cast<int>(size) - 2;
-        }
-    }
-    for (int i = static_cast<int>(size) - 1; i >= 0; --i)
+    return FrameIndexBinary(AdjustTimeToFitTrack(time, looping));
+}
+
+template <typename T, int N>
+int Track<T, N>::FrameIndex(float trackTime, TrackCursor& cursor)
+{
+    // Expects a time that already went through AdjustTimeToFitTrack
+    if (mFrames.size() <= 1)
     {
-        if (time >= mFrames[i].mTime)
-        {
-            return i;
-        }
+        return -1;
     }
-    // Invalid code, we should not reach here!
-    return -1;
-} // End of FrameIndex
+    return TrackHelpers::FrameIndexFromCursor(&mFrames[0].mTime, sizeof(Frame<N>) / sizeof(float),
+                                              static_cast<unsigned>(mFrames.size()), trackTime, cursor);
+}
+
+template <typename T, int N>
+int Track<T, N>::FrameIndexBinary(float trackTime)
+{
+    return TrackHelpers::FrameIndexBinary(&mFrames[0].mTime, sizeof(Frame<N>) / sizeof(float),
+                                          static_cast<unsigned>(mFrames.size()), trackTime);
+}
 
 template <typename T, int N>
 float Track<T, N>::AdjustTimeToFitTrack(float time, bool looping)
 {
-    const unsigned int size = static_cast<unsigned>(mFrames.size());
-    if (size <= 1) { return 0.0f; }
-
-    const float startTime = mFrames[0].mTime;
-    const float endTime = mFrames[size - 1].mTime;
-    const float duration = endTime - startTime;
-    if (duration <= 0.0f) { return 0.0f; }
-    if (looping)
+    if (mFrames.empty())
     {
-        time = fmodf(time - startTime, endTime - startTime);
-        if (time < 0.0f)
-        {
-            time += endTime - startTime;
-        }
-        time = time + startTime;
-    }
-    else
-    {
-        if (time <= mFrames[0].mTime) { time = startTime; }
-        if (time >= mFrames[size - 1].mTime) { time = endTime; }
+        return 0.0f;
     }
+    return TrackHelpers::AdjustTimeToFitTimes(&mFrames[0].mTime, sizeof(Frame<N>) / sizeof(float),
+                                              static_cast<unsigned>(mFrames.size()), time, looping);
+}
 
-    return time;
+template <typename T, int N>
+T Track<T, N>::Cast(float* value)
+{
+    return TrackHelpers::Cast<T>(value);
 }
 
-template <>
-float Track<float, 1>::Cast(float* value)
+template <typename T, int N>
+T Track<T, N>::SampleConstant(float time, bool looping)
 {
-    return value[0];
+    return SampleConstant(FrameIndex(time, looping));
 }
 
-template <>
-Vec3 Track<Vec3, 3>::Cast(float* value)
+template <typename T, int N>
+T Track<T, N>::SampleLinear(float time, bool looping)
 {
-    return Vec3(value[0], value[1], value[2]);
+    return SampleLinear(FrameIndex(time, looping), AdjustTimeToFitTrack(time, looping));
 }
 
-template <>
-Quat Track<Quat, 4>::Cast(float* value)
+template <typename T, int N>
+T Track<T, N>::SampleCubic(float time, bool looping)
 {
-    auto r = Quat(value[0], value[1], value[2], value[3]);
-    return r.Normalized();
+    return SampleCubic(FrameIndex(time, looping), AdjustTimeToFitTrack(time, looping));
 }
 
 template <typename T, int N>
-T Track<T, N>::SampleConstant(float time, bool looping)
+T Track<T, N>::SampleConstant(int frame)
 {
-    int frame = FrameIndex(time, looping);
     if (frame < 0 || frame >= static_cast<int>(mFrames.size()))
     {
         return T();
@@ -244,16 +228,14 @@ T Track<T, N>::SampleConstant(float time, bool looping)
 }
 
 template <typename T, int N>
-T Track<T, N>::SampleLinear(float time, bool looping)
+T Track<T, N>::SampleLinear(int thisFrame, float trackTime)
 {
-    int thisFrame = FrameIndex(time, looping);
     if (thisFrame < 0 || thisFrame >= static_cast<int>(mFrames.size() - 1))
     {
         return T();
     }
     int nextFrame = thisFrame + 1;
 
-    float trackTime = AdjustTimeToFitTrack(time, looping);
     float frameDelta = mFrames[nextFrame].mTime - mFrames[thisFrame].mTime;
     if (frameDelta <= 0.0f)
     {
@@ -268,16 +250,14 @@ T Track<T, N>::SampleLinear(float time, bool looping)
 }
 
 template <typename T, int N>
-T Track<T, N>::SampleCubic(float time, bool looping)
+T Track<T, N>::SampleCubic(int thisFrame, float trackTime)
 {
-    int thisFrame = FrameIndex(time, looping);
     if (thisFrame < 0 || thisFrame >= static_cast<int>(mFrames.size() - 1))
     {
         return T();
     }
     int nextFrame = thisFrame + 1;
 
-    float trackTime = AdjustTimeToFitTrack(time, looping);
     float frameDelta = mFrames[nextFrame].mTime - mFrames[thisFrame].mTime;
     if (frameDelta <= 0.0f)
     {
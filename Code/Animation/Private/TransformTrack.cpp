@@ -1,41 +1,52 @@
 #include "Animation/Public/TransformTrack.h"
 
-TransformTrack::TransformTrack()
+template TTransformTrack<VectorTrack, QuaternionTrack>;
+template TTransformTrack<CompressedVectorTrack, CompressedQuaternionTrack>;
+
+template <typename VTRACK, typename QTRACK>
+TTransformTrack<VTRACK, QTRACK>::TTransformTrack()
 {
     mId = 0;
 }
 
-unsigned int TransformTrack::GetId() const
+template <typename VTRACK, typename QTRACK>
+unsigned int TTransformTrack<VTRACK, QTRACK>::GetId() const
 {
     return mId;
 }
 
-void TransformTrack::SetId(unsigned int id)
+template <typename VTRACK, typename QTRACK>
+void TTransformTrack<VTRACK, QTRACK>::SetId(unsigned int id)
 {
     mId = id;
 }
 
-VectorTrack& TransformTrack::GetPositionTrack()
+template <typename VTRACK, typename QTRACK>
+VTRACK& TTransformTrack<VTRACK, QTRACK>::GetPositionTrack()
 {
     return mPosition;
 }
 
-QuaternionTrack& TransformTrack::GetRotationTrack()
+template <typename VTRACK, typename QTRACK>
+QTRACK& TTransformTrack<VTRACK, QTRACK>::GetRotationTrack()
 {
     return mRotation;
 }
 
-VectorTrack& TransformTrack::GetScaleTrack()
+template <typename VTRACK, typename QTRACK>
+VTRACK& TTransformTrack<VTRACK, QTRACK>::GetScaleTrack()
 {
     return mScale;
 }
 
-bool TransformTrack::IsValid()
+template <typename VTRACK, typename QTRACK>
+bool TTransformTrack<VTRACK, QTRACK>::IsValid()
 {
     return mPosition.Size() > 1 || mRotation.Size() > 1 || mScale.Size() > 1;
 }
 
-float TransformTrack::GetStartTime()
+template <typename VTRACK, typename QTRACK>
+float TTransformTrack<VTRACK, QTRACK>::GetStartTime()
 {
     float result = 0.0f;
     bool isSet = false;
@@ -67,7 +78,8 @@ float TransformTrack::GetStartTime()
     return result;
 }
 
-float TransformTrack::GetEndTime()
+template <typename VTRACK, typename QTRACK>
+float TTransformTrack<VTRACK, QTRACK>::GetEndTime()
 {
     float result = 0.0f;
     bool isSet = false;
@@ -99,24 +111,90 @@ float TransformTrack::GetEndTime()
     return result;
 }
 
-Transform TransformTrack::Sample(const Transform& ref,
-                                 float time, bool looping)
+template <typename VTRACK, typename QTRACK>
+Transform TTransformTrack<VTRACK, QTRACK>::Sample(const Transform& ref,
+                                                  float time, bool looping)
 {
     Transform result = ref; // Assign default values
-    if (mPosition.Size() > 1)
+    if (mPosition.Size() > 0)
     {
-        // Only assign if animated
+        // Only assign if animated, a single key is a constant value
         result.position = mPosition.Sample(time, looping);
     }
-    if (mRotation.Size() > 1)
+    if (mRotation.Size() > 0)
     {
         // Only assign if animated
         result.rotation = mRotation.Sample(time, looping);
     }
-    if (mScale.Size() > 1)
+    if (mScale.Size() > 0)
     {
         // Only assign if animated
         result.scale = mScale.Sample(time, looping);
     }
     return result;
 }
+
+template <typename VTRACK, typename QTRACK>
+Transform TTransformTrack<VTRACK, QTRACK>::Sample(const Transform& ref,
+                                                  float time, bool looping, TransformTrackCursor& cursor)
+{
+    Transform result = ref; // Assign default values
+    if (mPosition.Size() > 0)
+    {
+        result.position = mPosition.Sample(time, looping, cursor.mPosition);
+    }
+    if (mRotation.Size() > 0)
+    {
+        result.rotation = mRotation.Sample(time, looping, cursor.mRotation);
+    }
+    if (mScale.Size() > 0)
+    {
+        result.scale = mScale.Sample(time, looping, cursor.mScale);
+    }
+    return result;
+}
+
+template <typename VTRACK, typename QTRACK>
+Transform TTransformTrack<VTRACK, QTRACK>::Sample(const Transform& ref,
+                                                  const TimelineSample* samples, const TransformTimelines& timelines)
+{
+    // Segments were resolved by the clip, single key tracks have no timeline and return their constant
+    Transform result = ref;
+    if (timelines.mPosition >= 0)
+    {
+        result.position = mPosition.Sample(samples[timelines.mPosition]);
+    }
+    else if (mPosition.Size() > 0)
+    {
+        result.position = mPosition.Sample(0.0f, false);
+    }
+    if (timelines.mRotation >= 0)
+    {
+        result.rotation = mRotation.Sample(samples[timelines.mRotation]);
+    }
+    else if (mRotation.Size() > 0)
+    {
+        result.rotation = mRotation.Sample(0.0f, false);
+    }
+    if (timelines.mScale >= 0)
+    {
+        result.scale = mScale.Sample(samples[timelines.mScale]);
+    }
+    else if (mScale.Size() > 0)
+    {
+        result.scale = mScale.Sample(0.0f, false);
+    }
+    return result;
+}
+
+CompressedTransformTrack CompressTransformTrack(TransformTrack& input)
+{
+    CompressedTransformTrack result;
+
+    result.SetId(input.GetId());
+    result.GetPositionTrack().Set(input.GetPositionTrack());
+    result.GetRotationTrack().Set(input.GetRotationTrack());
+    result.GetScaleTrack().Set(input.GetScaleTrack());
+
+    return result;
+}
@@ -3,27 +3,75 @@
 #include <vector>
 #include <string>
 #include "TransformTrack.h"
+#include "Timeline.h"
 #include "Pose.h"
+#include "SoaPose.h"
 
-class Clip
+// How far apart two keys can be and still count as the same value
+#define CLIP_CONSTANT_EPSILON 0.00001f
+
+// Instances SampleMany poses together, few enough that their poses stay in cache across tracks
+#define CLIP_SAMPLE_MANY_BLOCK 32
+
+// Per-instance sampling state for a Clip, one cursor per transform track.
+// Every AnimationInstance owns its own, so instances playing the same clip don't fight over it.
+struct ClipCursor
+{
+    std::vector<TransformTrackCursor> mTracks;
+    std::vector<TrackCursor> mTimelines;
+    std::vector<TimelineSample> mSamples;
+};
+
+// Wrapped times and resolved segments of one SampleMany call. The caller owns it, so threads
+// sampling the same clip each pass their own, and keeps it between calls so they don't allocate.
+struct ClipSampleManyScratch
+{
+    std::vector<float> mTimes;
+    std::vector<TimelineSample> mSamples;
+};
+
+// Tracks keyed on the same times share a Timeline, an index over the keys' own times that any
+// pass changing keys or tracks has to rebuild with UpdateTimelines.
+template <typename TRACK>
+class TClip
 {
 protected:
-    std::vector<TransformTrack> mTracks;
+    std::vector<TRACK> mTracks;
+    std::vector<Timeline> mTimelines;
+    std::vector<TransformTimelines> mTrackTimelines;
     std::string mName;
     float mStartTime;
     float mEndTime;
     bool mLooping;
     
     float AdjustTimeToFitRange(float inTime) const;
+    bool HasTimelines() const;
+    template <typename POSE>
+    float SampleInto(POSE& outPose, float inTime);
+    template <typename POSE>
+    float SampleInto(POSE& outPose, float inTime, ClipCursor& cursor);
     
 public:
-    Clip();
+    TClip();
     unsigned int GetIdAtIndex(unsigned int index);
     void SetIdAtIndex(unsigned int index, unsigned int id);
+    void RemoveTrackAtIndex(unsigned int index);
     unsigned int Size() const;
     float Sample(Pose& outPose, float inTime);
-    TransformTrack& operator[](unsigned int index);
+    float Sample(Pose& outPose, float inTime, ClipCursor& cursor);
+    // Same lookups as the Pose overloads, written into one lane array per component
+    float Sample(SoaPose& outPose, float inTime);
+    float Sample(SoaPose& outPose, float inTime, ClipCursor& cursor);
+    // Poses many instances track by track, so each track's keys are loaded once for all of them
+    void SampleMany(const float* inTimes, Pose* outPoses, unsigned int count, ClipSampleManyScratch& scratch,
+                    float* outTimes = nullptr);
+    TRACK& operator[](unsigned int index);
     void RecalculateDuration();
+    void SetTimeRange(float startTime, float endTime);
+    // Editing passes like ReduceTrack change one track at a time and can split a timeline,
+    // run this after them. Without timelines every track does its own lookup.
+    void UpdateTimelines();
+    unsigned int GetNumTimelines() const;
     std::string& GetName();
     void SetName(const std::string& inNewName);
     float GetDuration() const;
@@ -32,3 +80,56 @@ public:
     bool GetLooping() const;
     void SetLooping(bool inLooping);
 };
+
+using Clip = TClip<TransformTrack>;
+using CompressedClip = TClip<CompressedTransformTrack>;
+
+// Worst local error of each component of one joint's compressed track, rotation in degrees
+struct TrackCompressionError
+{
+    unsigned int mJoint;
+    float mPositionError;
+    float mRotationError;
+    float mScaleError;
+};
+
+// Sizes and worst local errors over every track of a compressed clip, rotation in degrees.
+// mTracks holds one entry per transform track, in the clip's track order.
+struct CompressionStats
+{
+    unsigned int mOriginalBytes;
+    unsigned int mCompressedBytes;
+    float mMaxPositionError;
+    float mMaxRotationError;
+    float mMaxScaleError;
+    std::vector<TrackCompressionError> mTracks;
+
+    CompressionStats() : mOriginalBytes(0), mCompressedBytes(0), mMaxPositionError(0.0f),
+        mMaxRotationError(0.0f), mMaxScaleError(0.0f)
+    {
+    }
+};
+
+// Quantizes every track of the clip. Measuring the error resamples every track, leave
+// outStats null to skip it.
+CompressedClip CompressClip(Clip& input, CompressionStats* outStats = nullptr);
+
+// Component tracks StripConstantTracks collapsed to one key or removed, and the joints it
+// left with nothing to animate
+struct ConstantTrackStats
+{
+    unsigned int mCollapsed;
+    unsigned int mRemoved;
+    unsigned int mJointsRemoved;
+
+    ConstantTrackStats() : mCollapsed(0), mRemoved(0), mJointsRemoved(0)
+    {
+    }
+};
+
+// Collapses every component track whose keys are all equal into a single key, and drops the
+// ones whose value matches the rest pose. Joints left with nothing to animate are removed.
+// The clip keeps its time range and its timelines are detected again. Sampling a stripped clip
+// leaves those components as they are in the pose, so the pose has to start from the rest pose
+// and be reset to it when the clip changes.
+ConstantTrackStats StripConstantTracks(Clip& clip, const Pose& restPose);
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include "Track.h"
+
+// Quaternions keep their three smallest components, the dropped one is rebuilt from the unit length
+#define COMPRESSED_QUAT_SCALE 0.70710678118f
+
+// Keyframe track with 16 bit quantized values. Vectors and scalars are range normalized
+// against a per track minimum and extent, quaternions are stored as smallest three in 48 bits.
+// Tangents only exist for cubic tracks and are range normalized like vectors.
+template <typename T, int N>
+class CompressedTrack
+{
+public:
+    static const int ValueShorts = N > 3 ? 3 : N;
+protected:
+    std::vector<float> mTimes;
+    std::vector<unsigned short> mValues;
+    std::vector<unsigned short> mInTangents;
+    std::vector<unsigned short> mOutTangents;
+    float mValueMin[N];
+    float mValueExtent[N];
+    float mTangentMin[N];
+    float mTangentExtent[N];
+    Interpolation mInterpolation;
+protected:
+    void EncodeValue(const float* value, unsigned short* outQuantized);
+    T DecodeValue(unsigned int frame);
+    T DecodeTangent(const std::vector<unsigned short>& tangents, unsigned int frame);
+    int FrameIndex(float trackTime);
+    int FrameIndex(float trackTime, TrackCursor& cursor);
+    float AdjustTimeToFitTrack(float time, bool looping);
+    T SampleSegment(int frame, float trackTime);
+public:
+    CompressedTrack();
+    void Set(Track<T, N>& track);
+    unsigned int Size();
+    unsigned int GetMemorySize();
+    Interpolation GetInterpolation() const;
+    float GetStartTime();
+    float GetEndTime();
+    T Sample(float time, bool looping);
+    T Sample(float time, bool looping, TrackCursor& cursor);
+    T Sample(const TimelineSample& sample);
+    float GetTime(unsigned int index);
+};
+
+using CompressedScalarTrack = CompressedTrack<float, 1>;
+using CompressedVectorTrack = CompressedTrack<Vec3, 3>;
+using CompressedQuaternionTrack = CompressedTrack<Quat, 4>;
+
+// Largest difference between the two tracks at every key and halfway between keys.
+// Distance for scalars and vectors, angle in radians for quaternions.
+template <typename T, int N>
+float CompressionError(Track<T, N>& original, CompressedTrack<T, N>& compressed, bool looping);
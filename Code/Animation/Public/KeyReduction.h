@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Clip.h"
+#include "Skeleton.h"
+
+// Default model space tolerances, in skeleton units, degrees and scale factor
+#define KEY_REDUCTION_POSITION_TOLERANCE 0.001f
+#define KEY_REDUCTION_ANGLE_TOLERANCE 0.1f
+#define KEY_REDUCTION_SCALE_TOLERANCE 0.001f
+
+struct KeyReductionSettings
+{
+    float mPositionTolerance;
+    float mAngleTolerance;
+    float mScaleTolerance;
+
+    KeyReductionSettings() :
+        mPositionTolerance(KEY_REDUCTION_POSITION_TOLERANCE),
+        mAngleTolerance(KEY_REDUCTION_ANGLE_TOLERANCE),
+        mScaleTolerance(KEY_REDUCTION_SCALE_TOLERANCE)
+    {
+    }
+};
+
+// Key counts around a ReduceClip and the largest model space error it measured, rotation in degrees
+struct KeyReductionStats
+{
+    unsigned int mKeysBefore;
+    unsigned int mKeysAfter;
+    float mMaxPositionError;
+    float mMaxAngleError;
+    float mMaxScaleError;
+
+    KeyReductionStats() : mKeysBefore(0), mKeysAfter(0), mMaxPositionError(0.0f), mMaxAngleError(0.0f),
+        mMaxScaleError(0.0f)
+    {
+    }
+};
+
+// Removes every key of a constant or linear track that interpolating its kept neighbours
+// reproduces within tolerance. Cubic tracks are left alone. Returns the number of keys removed.
+template <typename T, int N>
+unsigned int ReduceTrack(Track<T, N>& track, float tolerance);
+
+// Reduces every track of the clip. The model space tolerances are split into per joint local
+// tolerances using the depth of the skeleton and how far each joint's descendants reach in the
+// rest pose and while the clip plays, so a rotation near the root is held tighter than one on
+// a finger. Timelines are detected again afterwards, tracks reduced differently stop sharing one.
+// Returns the key counts before and after, and the largest model space error measured.
+KeyReductionStats ReduceClip(Clip& clip, Skeleton& skeleton,
+                             const KeyReductionSettings& settings = KeyReductionSettings());
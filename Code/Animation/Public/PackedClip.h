@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "Clip.h"
+#include "Interpolation.h"
+#include "Pose.h"
+#include "SoaPose.h"
+#include "Math/Public/Simd.h"
+
+// One group per component and interpolation mode pair
+#define PACKED_CLIP_NUM_GROUPS 9
+
+// Linear groups are sampled four tracks at a time with SSE when the target has it
+#define PACKED_CLIP_SSE MATH_SSE
+
+enum class PackedComponent
+{
+    Position,
+    Rotation,
+    Scale
+};
+
+// Offset table entry for one animated component of one joint.
+// Offsets are in floats from the start of the section they index, tracks keyed on the same
+// times share one slice of the time section, only cubic tracks own a slice of the tangent sections.
+struct PackedTrack
+{
+    unsigned int mJoint;
+    PackedComponent mComponent;
+    Interpolation mInterpolation;
+    unsigned int mNumFrames;
+    unsigned int mTimeOffset;
+    unsigned int mValueOffset;
+    unsigned int mTangentOffset;
+};
+
+// A run of key times in the time section, shared by every track keyed on exactly those times.
+// The lookup table slice is built at load time and is never cooked.
+struct PackedTimeRun
+{
+    unsigned int mOffset;
+    unsigned int mNumFrames;
+    unsigned int mTableOffset;
+    unsigned int mTableSize;
+};
+
+// Per-instance sampling state for a PackedClip, a cursor and a resolved segment per time run.
+// Every AnimationInstance owns its own, so instances playing the same clip don't fight over it.
+struct PackedClipCursor
+{
+    std::vector<TrackCursor> mRuns;
+    std::vector<TimelineSample> mSamples;
+};
+
+// Read-only clip that keeps every key time, value and tangent of every track in one
+// allocation, split into 16 byte aligned sections. Samples to the same pose as Clip::Sample,
+// writing only the joint components the clip animates.
+// Tracks are grouped by component and interpolation, and each group is sampled by its own
+// template instantiation, so there is no per key interpolation branch. Linear groups blend
+// four tracks per step in SSE registers and write straight into the pose's joint array.
+// With a cursor, each time run is wrapped and searched once for all of its tracks, starting
+// from where it was last sampled. Without one, every track does its own binary search.
+// Runs with a lookup table skip the search for a table load either way.
+class PackedClip
+{
+protected:
+    std::vector<PackedTrack> mTracks;
+    std::vector<PackedTimeRun> mTimeRuns;
+    // Index into mTimeRuns of every track
+    std::vector<unsigned int> mTrackRuns;
+    // Every run's frame lookup table back to back, empty when mLookupRate is 0
+    std::vector<unsigned int> mLookupTable;
+    float mLookupRate;
+    unsigned int mGroupOffsets[PACKED_CLIP_NUM_GROUPS + 1];
+    unsigned char* mAllocation;
+    float* mTimes;
+    float* mValues;
+    float* mInTangents;
+    float* mOutTangents;
+    unsigned int mNumTimes;
+    unsigned int mNumValues;
+    unsigned int mNumTangents;
+    std::string mName;
+    float mStartTime;
+    float mEndTime;
+    bool mLooping;
+
+    float AdjustTimeToFitRange(float inTime) const;
+    void Allocate(unsigned int numTimes, unsigned int numValues, unsigned int numTangents);
+    void Free();
+    void UpdateTimeRuns();
+    template <typename POSE>
+    float SampleInto(POSE& outPose, float inTime, PackedClipCursor* cursor) const;
+public:
+    PackedClip();
+    PackedClip(const PackedClip& other);
+    PackedClip& operator=(const PackedClip& other);
+    ~PackedClip();
+
+    void Set(Clip& clip);
+    // Samples data in place instead of owning a copy, data is laid out like GetData with the
+    // given section sizes in floats and has to be 16 byte aligned. The caller keeps it alive and
+    // unchanged while the clip uses it, copies of the clip own their data again.
+    void SetView(const std::vector<PackedTrack>& tracks, const unsigned int* groupOffsets, const float* data,
+                 unsigned int numTimes, unsigned int numValues, unsigned int numTangents);
+    float Sample(Pose& outPose, float inTime) const;
+    float Sample(Pose& outPose, float inTime, PackedClipCursor& cursor) const;
+    // Same lookups as the Pose overloads, written into the component's channels
+    float Sample(SoaPose& outPose, float inTime) const;
+    float Sample(SoaPose& outPose, float inTime, PackedClipCursor& cursor) const;
+    // Builds a table per time run with sampleRate buckets per second, 0 drops them.
+    // Costs about one unsigned int per bucket per run, kept across Set and SetView.
+    void UpdateIndexLookupTables(float sampleRate);
+
+    unsigned int Size() const;
+    const PackedTrack& GetTrack(unsigned int index) const;
+    const std::vector<PackedTrack>& GetTracks() const;
+    unsigned int GetNumTimeRuns() const;
+    // PACKED_CLIP_NUM_GROUPS + 1 track offsets, group i is [offsets[i], offsets[i + 1])
+    const unsigned int* GetGroupOffsets() const;
+    // Times, values, in tangents and out tangents back to back
+    const float* GetData() const;
+    unsigned int GetNumTimes() const;
+    unsigned int GetNumValues() const;
+    unsigned int GetNumTangents() const;
+    unsigned int GetDataSize() const;
+    std::string& GetName();
+    float GetDuration() const;
+    float GetStartTime() const;
+    float GetEndTime() const;
+    void SetTimeRange(float startTime, float endTime);
+    bool GetLooping() const;
+    void SetLooping(bool inLooping);
+};
+
+PackedClip PackClip(Clip& input);
@@ -2,12 +2,40 @@
 
 #include <vector>
 #include "Math/Public/Transform.h"
+#include "Math/Public/DualQuat.h"
+#include "Math/Public/Mat3x4.h"
 
+// Joints recomputed by the world transform and palette caches since the last reset
+struct PoseCacheStats
+{
+    unsigned int mTransforms;
+    unsigned int mMatrices;
+
+    PoseCacheStats() : mTransforms(0), mMatrices(0)
+    {
+    }
+};
+
+// World transforms and palette matrices are cached per joint. SetLocalTransform marks a joint
+// dirty only when its value changes, and the next GetGlobalTransform or GetMatrixPalette
+// recomputes the dirty joints and their children. Reading a pose updates its caches, so one
+// pose must not be read from several threads at once.
 class Pose
 {
 protected:
     std::vector<Transform> mJoints;
     std::vector<int> mParents;
+
+    // Bit 0 marks a stale world transform, bit 1 a stale palette matrix
+    mutable std::vector<unsigned char> mDirty;
+    mutable std::vector<Transform> mGlobals;
+    mutable std::vector<Mat4> mPalette;
+    mutable unsigned char mAnyDirty;
+    mutable PoseCacheStats mStats;
+
+    Transform WalkGlobalTransform(unsigned int index) const;
+    void MarkAllDirty();
+    void UpdateCache(unsigned char mask) const;
 public:
     Pose();
     Pose(const Pose& p);
@@ -17,12 +45,27 @@ public:
     unsigned int Size() const;
     Transform GetLocalTransform(unsigned int index) const;
     void SetLocalTransform(unsigned int index, const Transform& transform);
+    Transform* GetLocalTransforms();
+    void MarkDirty(unsigned int index);
     Transform GetGlobalTransform(unsigned int index) const;
     Transform operator[](unsigned int index);
     void GetMatrixPalette(std::vector<Mat4>& out) const;
+    void GetSkinPalette(const std::vector<Mat4>& invBindPose, std::vector<Mat4>& out) const;
+    // The joints overloads build a skin's palette, joints maps each palette slot to a pose joint
+    void GetSkinPalette(const std::vector<Mat4>& invBindPose, const std::vector<unsigned int>& joints,
+                        std::vector<Mat4>& out) const;
+    void GetAffineSkinPalette(const std::vector<Mat4>& invBindPose, std::vector<Mat3x4>& out) const;
+    void GetAffineSkinPalette(const std::vector<Mat4>& invBindPose, const std::vector<unsigned int>& joints,
+                              std::vector<Mat3x4>& out) const;
+    void GetDualQuatPalette(std::vector<DualQuat>& out) const;
+    void GetDualQuatSkinPalette(const std::vector<DualQuat>& invBindPose, std::vector<DualQuat>& out) const;
+    void GetDualQuatSkinPalette(const std::vector<DualQuat>& invBindPose, const std::vector<unsigned int>& joints,
+                                std::vector<DualQuat>& out) const;
     int GetParent(unsigned int index) const;
     void SetParent(unsigned int index, int parent);
+    PoseCacheStats GetCacheStats() const;
+    void ResetCacheStats();
 
     bool operator==(const Pose& other);
     bool operator!=(const Pose& other);
-};
\ No newline at end of file
+};
@@ -11,6 +11,7 @@ protected:
     Pose mRestPose;
     Pose mBindPose;
     std::vector<Mat4> mInvBindPose;
+    std::vector<DualQuat> mInvBindDualQuats;
     std::vector<std::string> mJointNames;
 
     void UpdateInverseBindPose();
@@ -23,6 +24,18 @@ public:
     Pose& GetBindPose();
     Pose& GetRestPose();
     std::vector<Mat4>& GetInvBindPose();
+    // Final skinning matrices for the pose, one per joint
+    void GetSkinPalette(const Pose& pose, std::vector<Mat4>& out) const;
+    // Palettes for one skin: joints maps each palette slot to a joint, see Mesh::GetSkinJoints
+    void GetSkinPalette(const Pose& pose, const std::vector<unsigned int>& joints, std::vector<Mat4>& out) const;
+    // Same matrices as GetSkinPalette as 3x4 rows, a quarter less to upload
+    void GetAffineSkinPalette(const Pose& pose, std::vector<Mat3x4>& out) const;
+    void GetAffineSkinPalette(const Pose& pose, const std::vector<unsigned int>& joints, std::vector<Mat3x4>& out) const;
+    std::vector<DualQuat>& GetInvBindDualQuats();
+    // Dual quaternion skinning transforms for the pose, scale is ignored
+    void GetDualQuatSkinPalette(const Pose& pose, std::vector<DualQuat>& out) const;
+    void GetDualQuatSkinPalette(const Pose& pose, const std::vector<unsigned int>& joints,
+                                std::vector<DualQuat>& out) const;
     std::vector<std::string>& GetJointNames();
     std::string& GetJointName(unsigned int index);
 };
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include "Animation/Public/Pose.h"
+#include "Math/Public/Mat4.h"
+#include "Math/Public/Simd.h"
+
+// Palette and blend kernels run four joints at a time with SSE when the target has it
+#define SOA_POSE_SSE MATH_SSE
+
+enum class SoaChannel
+{
+    PositionX,
+    PositionY,
+    PositionZ,
+    RotationX,
+    RotationY,
+    RotationZ,
+    RotationW,
+    ScaleX,
+    ScaleY,
+    ScaleZ,
+    Count
+};
+
+// Pose with one 16 byte aligned float array per channel instead of an array of Transforms,
+// so the same channel of four joints loads into one SSE register. Arrays are padded to a
+// multiple of four joints, and padding joints hold the identity transform.
+// Palette generation is fastest when every joint comes after its parent, as the glTF loader
+// orders them. Clip::Sample and PackedClip::Sample can write into it directly.
+class SoaPose
+{
+protected:
+    unsigned char* mAllocation;
+    float* mChannels[static_cast<int>(SoaChannel::Count)];
+    unsigned int mSize;
+    unsigned int mCapacity;
+    std::vector<int> mParents;
+
+    void Allocate(unsigned int capacity);
+    void Free();
+public:
+    SoaPose();
+    SoaPose(unsigned int numJoints);
+    SoaPose(const SoaPose& other);
+    SoaPose& operator=(const SoaPose& other);
+    ~SoaPose();
+
+    void Resize(unsigned int size);
+    unsigned int Size() const;
+    float* GetChannel(SoaChannel channel);
+    const float* GetChannel(SoaChannel channel) const;
+    Transform GetLocalTransform(unsigned int index) const;
+    void SetLocalTransform(unsigned int index, const Transform& transform);
+    Transform GetGlobalTransform(unsigned int index) const;
+    void GetMatrixPalette(std::vector<Mat4>& out) const;
+    void GetSkinPalette(const std::vector<Mat4>& invBindPose, std::vector<Mat4>& out) const;
+    void Blend(const SoaPose& a, const SoaPose& b, float t);
+    int GetParent(unsigned int index) const;
+    void SetParent(unsigned int index, int parent);
+
+    void Set(const Pose& pose);
+    void Get(Pose& outPose) const;
+};
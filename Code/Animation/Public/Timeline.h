@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include "Track.h"
+
+// Key times shared by every track of a clip that was keyed on the same input.
+// The clip wraps the time and finds the segment once per timeline, not once per track.
+class Timeline
+{
+protected:
+    std::vector<float> mTimes;
+
+    float AdjustTimeToFitTimeline(float time, bool looping) const;
+    int FrameIndexBinary(float trackTime) const;
+    int FrameIndex(float trackTime, TrackCursor& cursor) const;
+    TimelineSample MakeSample(int frame, float trackTime) const;
+public:
+    Timeline();
+    void Resize(unsigned int size);
+    unsigned int Size() const;
+    float& operator[](unsigned int index);
+    float operator[](unsigned int index) const;
+    TimelineSample Resolve(float time, bool looping) const;
+    TimelineSample Resolve(float time, bool looping, TrackCursor& cursor) const;
+};
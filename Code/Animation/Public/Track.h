@@ -6,6 +6,26 @@
 #include "Math/Public/Quat.h"
 #include "Interpolation.h"
 
+#define TRACK_CURSOR_MAX_STEPS 4
+
+// Remembers the segment a track was last sampled in. Steady playback only moves a
+// frame or two per update, so the next lookup starts from here instead of scanning.
+struct TrackCursor
+{
+    int mFrame;
+
+    TrackCursor() : mFrame(0)
+    {
+    }
+};
+
+// Segment found on a timeline shared by several tracks, t is the normalized position inside it
+struct TimelineSample
+{
+    int mFrame;
+    float mT;
+};
+
 template <typename T, int N>
 class Track
 {
@@ -16,8 +36,13 @@ protected:
     T SampleConstant(float time, bool looping);
     T SampleLinear(float time, bool looping);
     T SampleCubic(float time, bool looping);
+    T SampleConstant(int frame);
+    T SampleLinear(int frame, float trackTime);
+    T SampleCubic(int frame, float trackTime);
     T Hermite(float time, const T& point1, const T& slope1, const T& point2, const T& slope2);
     int FrameIndex(float time, bool looping);
+    int FrameIndex(float trackTime, TrackCursor& cursor);
+    int FrameIndexBinary(float trackTime);
     float AdjustTimeToFitTrack(float time, bool looping);
     T Cast(float* value);
 public:
@@ -29,6 +54,9 @@ public:
     float GetStartTime();
     float GetEndTime();
     T Sample(float time, bool looping);
+    T Sample(float time, bool looping, TrackCursor& cursor);
+    T Sample(const TimelineSample& sample);
+    float GetTime(unsigned int index);
     Frame<N>& operator[](unsigned int index);
 };
 
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "Animation/Public/Track.h"
+#include "Math/Public/Vec3.h"
+#include "Math/Public/Quat.h"
+#include <cmath>
+#include <vector>
+
+// Interpolation building blocks shared by every track representation,
+// so packed and compressed tracks produce the same values as Track.
+namespace TrackHelpers
+{
+    inline float Interpolate(float a, float b, float t)
+    {
+        return a + (b - a) * t;
+    }
+
+    inline Vec3 Interpolate(const Vec3& a, const Vec3& b, float t)
+    {
+        return Vec3::Lerp(a, b, t);
+    }
+
+    inline Quat Interpolate(const Quat& a, const Quat& b, float t)
+    {
+        Quat result = Quat::Mix(a, b, t);
+        if (Quat::Dot(a, b) < 0)
+        {
+            // Neighborhood
+            result = Quat::Mix(a, -b, t);
+        }
+        return result.Normalized(); //NLerp, not slerp
+    }
+
+    // Hermite helpers
+    inline float AdjustHermiteResult(float f)
+    {
+        return f;
+    }
+
+    inline Vec3 AdjustHermiteResult(const Vec3& v)
+    {
+        return v;
+    }
+
+    inline Quat AdjustHermiteResult(const Quat& q)
+    {
+        return q.Normalized();
+    }
+
+    inline void Neighborhood(const float& a, float& b)
+    {
+    }
+
+    inline void Neighborhood(const Vec3& a, Vec3& b)
+    {
+    }
+
+    inline void Neighborhood(const Quat& a, Quat& b)
+    {
+        if (Quat::Dot(a, b) < 0)
+        {
+            b = -b;
+        }
+    }
+
+    template <typename T>
+    T Hermite(float t, const T& p1, const T& s1, const T& _p2, const T& s2)
+    {
+        float tt = t * t;
+        float ttt = tt * t;
+
+        T p2 = _p2;
+        Neighborhood(p1, p2);
+
+        float h1 = 2.0f * ttt - 3.0f * tt + 1.0f;
+        float h2 = -2.0f * ttt + 3.0f * tt;
+        float h3 = ttt - 2.0f * tt + t;
+        float h4 = ttt - tt;
+
+        T result = p1 * h1 + p2 * h2 + s1 * h3 + s2 * h4;
+        return AdjustHermiteResult(result);
+    }
+
+    // Distance between two values, the angle in radians for quaternions
+    inline float Difference(float a, float b)
+    {
+        return fabsf(a - b);
+    }
+
+    inline float Difference(const Vec3& a, const Vec3& b)
+    {
+        // Not Vec3::Len, it snaps lengths under VEC3_EPSILON to zero
+        Vec3 delta = a - b;
+        return sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+    }
+
+    inline float Difference(const Quat& a, const Quat& b)
+    {
+        // atan2 of the relative rotation, acos of the dot product has no precision left for small angles
+        Quat delta = a.Normalized().Conjugate() * b.Normalized();
+        float sinHalf = sqrtf(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+        return 2.0f * atan2f(sinHalf, fabsf(delta.w));
+    }
+
+    // Key time lookups shared by every track representation and by shared timelines. Times are
+    // read with a stride in floats, so frames and plain time arrays both work.
+
+    // Wraps a looping time into the keyed range or clamps it, 0 when the keys span no time
+    inline float AdjustTimeToFitTimes(const float* times, unsigned int stride, unsigned int numFrames,
+                                      float time, bool looping)
+    {
+        if (numFrames <= 1) { return 0.0f; }
+
+        const float startTime = times[0];
+        const float endTime = times[(numFrames - 1) * stride];
+        const float duration = endTime - startTime;
+        if (duration <= 0.0f) { return 0.0f; }
+        if (looping)
+        {
+            time = fmodf(time - startTime, duration);
+            if (time < 0.0f)
+            {
+                time += duration;
+            }
+            time = time + startTime;
+        }
+        else
+        {
+            if (time <= startTime) { time = startTime; }
+            if (time >= endTime) { time = endTime; }
+        }
+        return time;
+    }
+
+    // Last segment whose start time is not after trackTime
+    inline int FrameIndexBinary(const float* times, unsigned int stride, unsigned int numFrames, float trackTime)
+    {
+        int low = 0;
+        int high = static_cast<int>(numFrames) - 2;
+        while (low < high)
+        {
+            int middle = (low + high + 1) / 2;
+            if (times[middle * stride] <= trackTime)
+            {
+                low = middle;
+            }
+            else
+            {
+                high = middle - 1;
+            }
+        }
+        return low;
+    }
+
+    // Walks forward a few segments from where the cursor was last time, steady playback only
+    // moves a frame or two per update. A time that jumped further seeks with a binary search.
+    inline int FrameIndexFromCursor(const float* times, unsigned int stride, unsigned int numFrames,
+                                    float trackTime, TrackCursor& cursor)
+    {
+        const int lastSegment = static_cast<int>(numFrames) - 2;
+        if (lastSegment < 0)
+        {
+            cursor.mFrame = 0;
+            return 0;
+        }
+
+        int frame = cursor.mFrame;
+        if (frame < 0 || frame > lastSegment)
+        {
+            frame = 0;
+        }
+
+        if (trackTime >= times[frame * stride])
+        {
+            for (int step = 0; step < TRACK_CURSOR_MAX_STEPS; ++step)
+            {
+                if (frame == lastSegment || trackTime < times[(frame + 1) * stride])
+                {
+                    cursor.mFrame = frame;
+                    return frame;
+                }
+                ++frame;
+            }
+        }
+        else if (trackTime < times[stride])
+        {
+            // Looping playback wrapped around to the first segment
+            cursor.mFrame = 0;
+            return 0;
+        }
+
+        frame = FrameIndexBinary(times, stride, numFrames, trackTime);
+        cursor.mFrame = frame;
+        return frame;
+    }
+
+    // Appends a fixed rate table from a time bucket to the segment it starts in, so finding the
+    // segment for a time is one multiply and one table load instead of a search. Returns the
+    // number of entries appended, none for keys that span no time.
+    inline unsigned int BuildFrameLookupTable(std::vector<unsigned int>& outTable, const float* times,
+                                              unsigned int stride, unsigned int numFrames, float sampleRate)
+    {
+        if (numFrames <= 1 || sampleRate <= 0.0f)
+        {
+            return 0;
+        }
+        const float startTime = times[0];
+        const float duration = times[(numFrames - 1) * stride] - startTime;
+        if (duration <= 0.0f)
+        {
+            return 0;
+        }
+
+        const unsigned int numSamples = static_cast<unsigned>(duration * sampleRate) + 2;
+        const size_t offset = outTable.size();
+        outTable.resize(offset + numSamples);
+
+        // Both the bucket times and the frames are sorted, so one sweep fills the table
+        unsigned int frame = 0;
+        for (unsigned int i = 0; i < numSamples; ++i)
+        {
+            const float sampleTime = startTime + static_cast<float>(i) / sampleRate;
+            while (frame < numFrames - 2 && sampleTime >= times[(frame + 1) * stride])
+            {
+                ++frame;
+            }
+            outTable[offset + i] = frame;
+        }
+        return numSamples;
+    }
+
+    // Last segment whose start time is not after trackTime, for a time already wrapped or clamped
+    inline int FrameIndexFromTable(const unsigned int* table, unsigned int tableSize, float sampleRate,
+                                   const float* times, unsigned int stride, unsigned int numFrames, float trackTime)
+    {
+        const float offset = (trackTime - times[0]) * sampleRate;
+        unsigned int bucket = offset > 0.0f ? static_cast<unsigned>(offset) : 0;
+        if (bucket >= tableSize)
+        {
+            bucket = tableSize - 1;
+        }
+
+        // A bucket can span more than one frame when keys are denser than the sample rate,
+        // and rounding can put a time just before its bucket's first frame
+        int frame = static_cast<int>(table[bucket]);
+        const int lastSegment = static_cast<int>(numFrames) - 2;
+        while (frame < lastSegment && trackTime >= times[(frame + 1) * stride])
+        {
+            ++frame;
+        }
+        while (frame > 0 && trackTime < times[frame * stride])
+        {
+            --frame;
+        }
+        return frame;
+    }
+
+    // Raw frame floats to a value, quaternions are normalized on the way out
+    template <typename T>
+    T Cast(const float* value);
+
+    template <>
+    inline float Cast<float>(const float* value)
+    {
+        return value[0];
+    }
+
+    template <>
+    inline Vec3 Cast<Vec3>(const float* value)
+    {
+        return Vec3(value[0], value[1], value[2]);
+    }
+
+    template <>
+    inline Quat Cast<Quat>(const float* value)
+    {
+        auto r = Quat(value[0], value[1], value[2], value[3]);
+        return r.Normalized();
+    }
+} // End Track Helpers namespace
@@ -1,24 +1,55 @@
 #pragma once
 
 #include "Track.h"
+#include "CompressedTrack.h"
 #include "Math/Public/Transform.h"
 
-class TransformTrack
+struct TransformTrackCursor
+{
+    TrackCursor mPosition;
+    TrackCursor mRotation;
+    TrackCursor mScale;
+};
+
+// Index of the clip timeline each component track was keyed on, -1 for tracks with fewer than two keys
+struct TransformTimelines
+{
+    int mPosition;
+    int mRotation;
+    int mScale;
+
+    TransformTimelines() : mPosition(-1), mRotation(-1), mScale(-1)
+    {
+    }
+};
+
+// Sample only writes the components that have keys, the others keep ref's value. A single key
+// holds its value for the whole clip, like a one key glTF channel. Components StripConstantTracks
+// removed rely on ref being the rest pose.
+template <typename VTRACK, typename QTRACK>
+class TTransformTrack
 {
 protected:
     unsigned int mId;
-    VectorTrack mPosition;
-    QuaternionTrack mRotation;
-    VectorTrack mScale;
+    VTRACK mPosition;
+    QTRACK mRotation;
+    VTRACK mScale;
 public:
-    TransformTrack();
+    TTransformTrack();
     unsigned int GetId() const;
     void SetId(unsigned int id);
-    VectorTrack& GetPositionTrack();
-    QuaternionTrack& GetRotationTrack();
-    VectorTrack& GetScaleTrack();
+    VTRACK& GetPositionTrack();
+    QTRACK& GetRotationTrack();
+    VTRACK& GetScaleTrack();
     float GetStartTime();
     float GetEndTime();
     bool IsValid();
     Transform Sample(const Transform& ref, float time, bool looping);
-};
\ No newline at end of file
+    Transform Sample(const Transform& ref, float time, bool looping, TransformTrackCursor& cursor);
+    Transform Sample(const Transform& ref, const TimelineSample* samples, const TransformTimelines& timelines);
+};
+
+using TransformTrack = TTransformTrack<VectorTrack, QuaternionTrack>;
+using CompressedTransformTrack = TTransformTrack<CompressedVectorTrack, CompressedQuaternionTrack>;
+
+CompressedTransformTrack CompressTransformTrack(TransformTrack& input);
@@ -0,0 +1,599 @@
+#define _CRT_SECURE_NO_WARNINGS
+#include "Asset/Public/CookedAsset.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <type_traits>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define WIN32_EXTRA_LEAN
+#undef APIENTRY
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace CookedAssetHelpers
+{
+    static_assert(std::is_trivially_copyable<Transform>::value, "Transforms are cooked as raw bytes");
+    static_assert(std::is_trivially_copyable<PackedTrack>::value, "Packed tracks are cooked as raw bytes");
+
+    // Every array starts on a 16 byte boundary of the file
+    inline size_t AlignOffset(size_t offset)
+    {
+        return (offset + 15) & ~static_cast<size_t>(15);
+    }
+
+    // Streams the file into memory, it is written with a single fwrite
+    class Writer
+    {
+    protected:
+        std::vector<unsigned char> mBytes;
+    public:
+        template <typename T>
+        void Write(const T* data, size_t count)
+        {
+            const size_t offset = AlignOffset(mBytes.size());
+            mBytes.resize(offset + sizeof(T) * count, 0);
+            if (count > 0)
+            {
+                memcpy(&mBytes[offset], data, sizeof(T) * count);
+            }
+        }
+
+        template <typename T>
+        void Write(const std::vector<T>& data)
+        {
+            const unsigned int count = static_cast<unsigned>(data.size());
+            Write(&count, 1);
+            Write(data.data(), data.size());
+        }
+
+        void WriteString(const std::string& value)
+        {
+            const unsigned int length = static_cast<unsigned>(value.size());
+            Write(&length, 1);
+            Write(value.data(), value.size());
+        }
+
+        bool Save(const char* path)
+        {
+            FILE* file = fopen(path, "wb");
+            if (file == nullptr)
+            {
+                return false;
+            }
+            const size_t written = fwrite(mBytes.data(), 1, mBytes.size(), file);
+            fclose(file);
+            return written == mBytes.size();
+        }
+    };
+
+    // Walks the mapped file in the order Writer wrote it. Reads past the end return null and
+    // mark the reader invalid, so a truncated file fails the load instead of reading garbage.
+    class Reader
+    {
+    protected:
+        const unsigned char* mData;
+        size_t mSize;
+        size_t mOffset;
+        bool mValid;
+    public:
+        Reader(const void* data, size_t size) :
+            mData(static_cast<const unsigned char*>(data)), mSize(size), mOffset(0), mValid(true)
+        {
+        }
+
+        bool IsValid() const
+        {
+            return mValid;
+        }
+
+        template <typename T>
+        const T* Read(size_t count)
+        {
+            const size_t offset = AlignOffset(mOffset);
+            if (!mValid || offset > mSize || count > (mSize - offset) / sizeof(T))
+            {
+                mValid = false;
+                return nullptr;
+            }
+            mOffset = offset + sizeof(T) * count;
+            return reinterpret_cast<const T*>(mData + offset);
+        }
+
+        template <typename T>
+        T ReadValue()
+        {
+            const T* value = Read<T>(1);
+            return value == nullptr ? T() : *value;
+        }
+
+        // One copy into the vector, the counted layout Writer::Write(vector) produces
+        template <typename T>
+        void ReadVector(std::vector<T>& out)
+        {
+            const unsigned int count = ReadValue<unsigned int>();
+            const T* data = Read<T>(count);
+            if (data == nullptr)
+            {
+                out.clear();
+                return;
+            }
+            out.assign(data, data + count);
+        }
+
+        std::string ReadString()
+        {
+            const unsigned int length = ReadValue<unsigned int>();
+            const char* chars = Read<char>(length);
+            return chars == nullptr ? std::string() : std::string(chars, length);
+        }
+    };
+
+    // Ordered so there is no padding, the layout is the same for every compiler
+    struct Header
+    {
+        unsigned int mMagic;
+        unsigned int mVersion;
+        unsigned long long mSourceSize;
+        unsigned long long mSourceWriteTime;
+        float mPositionTolerance;
+        float mAngleTolerance;
+        float mScaleTolerance;
+        unsigned int mNumJoints;
+        unsigned int mNumMeshes;
+        unsigned int mNumClips;
+    };
+    static_assert(sizeof(Header) == 48, "The cooked header has no padding");
+
+    inline bool MatchesSource(const Header& header, const CookedAssetSource& source)
+    {
+        return header.mSourceSize == source.mSize && header.mSourceWriteTime == source.mWriteTime &&
+            header.mPositionTolerance == source.mReduction.mPositionTolerance &&
+            header.mAngleTolerance == source.mReduction.mAngleTolerance &&
+            header.mScaleTolerance == source.mReduction.mScaleTolerance;
+    }
+
+    void WritePose(Writer& writer, Pose& pose)
+    {
+        const unsigned int size = pose.Size();
+        std::vector<int> parents(size);
+        std::vector<Transform> joints(size);
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            parents[i] = pose.GetParent(i);
+            joints[i] = pose.GetLocalTransform(i);
+        }
+        writer.Write(parents.data(), size);
+        writer.Write(joints.data(), size);
+    }
+
+    // Every parent is a joint of the pose, and following parents always reaches a root
+    bool ValidParents(const int* parents, unsigned int size)
+    {
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            unsigned int depth = 0;
+            for (int joint = parents[i]; joint >= 0; joint = parents[joint])
+            {
+                if (joint >= static_cast<int>(size) || ++depth > size)
+                {
+                    return false;
+                }
+            }
+            if (parents[i] < -1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReadPose(Reader& reader, unsigned int size, Pose& outPose)
+    {
+        const int* parents = reader.Read<int>(size);
+        const Transform* joints = reader.Read<Transform>(size);
+        if (!reader.IsValid() || !ValidParents(parents, size))
+        {
+            return false;
+        }
+        outPose.Resize(size);
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            outPose.SetParent(i, parents[i]);
+            outPose.SetLocalTransform(i, joints[i]);
+        }
+        return true;
+    }
+    // Streams are empty or hold one entry per vertex, and every index and joint is in range
+    bool ValidMesh(Mesh& mesh, unsigned int numJoints)
+    {
+        const size_t numVertices = mesh.GetPosition().size();
+        if ((!mesh.GetNormal().empty() && mesh.GetNormal().size() != numVertices) ||
+            (!mesh.GetTexCoord().empty() && mesh.GetTexCoord().size() != numVertices) ||
+            mesh.GetWeights().size() != mesh.GetInfluences().size() ||
+            (!mesh.GetInfluences().empty() && mesh.GetInfluences().size() != numVertices))
+        {
+            return false;
+        }
+        for (unsigned int index : mesh.GetIndices())
+        {
+            if (index >= numVertices)
+            {
+                return false;
+            }
+        }
+        std::vector<unsigned int>& skinJoints = mesh.GetSkinJoints();
+        for (unsigned int joint : skinJoints)
+        {
+            if (joint >= numJoints)
+            {
+                return false;
+            }
+        }
+        // Influences index the skin's joints, or the whole skeleton without a skin
+        const int paletteSize = static_cast<int>(skinJoints.empty() ? numJoints : skinJoints.size());
+        for (const IVec4& influence : mesh.GetInfluences())
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                if (influence.v[c] < 0 || influence.v[c] >= paletteSize)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Tracks are sorted into the groups PackedClip samples them by, and every slice they
+    // read lies inside its section. Sums are 64 bit, so large offsets can't wrap around.
+    bool ValidTracks(const std::vector<PackedTrack>& tracks, const unsigned int* groupOffsets,
+                     const unsigned int* sections, unsigned int numJoints)
+    {
+        const unsigned int numTracks = static_cast<unsigned>(tracks.size());
+        if (groupOffsets[0] != 0 || groupOffsets[PACKED_CLIP_NUM_GROUPS] != numTracks)
+        {
+            return false;
+        }
+        for (unsigned int group = 0; group < PACKED_CLIP_NUM_GROUPS; ++group)
+        {
+            if (groupOffsets[group] > groupOffsets[group + 1])
+            {
+                return false;
+            }
+            for (unsigned int i = groupOffsets[group]; i < groupOffsets[group + 1]; ++i)
+            {
+                const PackedTrack& track = tracks[i];
+                const unsigned int component = static_cast<unsigned>(track.mComponent);
+                const unsigned int interpolation = static_cast<unsigned>(track.mInterpolation);
+                if (component > 2 || interpolation > 2 || component * 3 + interpolation != group ||
+                    track.mJoint >= numJoints || track.mNumFrames == 0 ||
+                    (track.mNumFrames == 1 && track.mInterpolation != Interpolation::Constant))
+                {
+                    return false;
+                }
+                const unsigned long long numFloats =
+                    static_cast<unsigned long long>(track.mNumFrames) * (component == 1 ? 4 : 3);
+                if (static_cast<unsigned long long>(track.mTimeOffset) + track.mNumFrames > sections[0] ||
+                    static_cast<unsigned long long>(track.mValueOffset) + numFloats > sections[1] ||
+                    (track.mInterpolation == Interpolation::Cubic &&
+                     static_cast<unsigned long long>(track.mTangentOffset) + numFloats > sections[2]))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+} // End of CookedAssetHelpers
+
+bool CookAsset(const char* path, const CookedAssetSource& source, Skeleton& skeleton, std::vector<Mesh>& meshes,
+               std::vector<Clip>& clips)
+{
+    CookedAssetHelpers::Writer writer;
+
+    CookedAssetHelpers::Header header;
+    header.mMagic = COOKED_ASSET_MAGIC;
+    header.mVersion = COOKED_ASSET_VERSION;
+    header.mSourceSize = source.mSize;
+    header.mSourceWriteTime = source.mWriteTime;
+    header.mPositionTolerance = source.mReduction.mPositionTolerance;
+    header.mAngleTolerance = source.mReduction.mAngleTolerance;
+    header.mScaleTolerance = source.mReduction.mScaleTolerance;
+    header.mNumJoints = skeleton.GetRestPose().Size();
+    header.mNumMeshes = static_cast<unsigned>(meshes.size());
+    header.mNumClips = static_cast<unsigned>(clips.size());
+    writer.Write(&header, 1);
+
+    CookedAssetHelpers::WritePose(writer, skeleton.GetRestPose());
+    CookedAssetHelpers::WritePose(writer, skeleton.GetBindPose());
+    std::vector<std::string>& names = skeleton.GetJointNames();
+    for (unsigned int i = 0; i < header.mNumJoints; ++i)
+    {
+        writer.WriteString(i < names.size() ? names[i] : std::string());
+    }
+
+    for (unsigned int i = 0; i < header.mNumMeshes; ++i)
+    {
+        Mesh& mesh = meshes[i];
+        writer.Write(mesh.GetPosition());
+        writer.Write(mesh.GetNormal());
+        writer.Write(mesh.GetTexCoord());
+        writer.Write(mesh.GetWeights());
+        writer.Write(mesh.GetInfluences());
+        writer.Write(mesh.GetIndices());
+        writer.Write(mesh.GetSkinJoints());
+    }
+
+    for (unsigned int i = 0; i < header.mNumClips; ++i)
+    {
+        PackedClip packed = PackClip(clips[i]);
+        writer.WriteString(packed.GetName());
+        const float timeRange[2] = { packed.GetStartTime(), packed.GetEndTime() };
+        writer.Write(timeRange, 2);
+        const unsigned int looping = packed.GetLooping() ? 1 : 0;
+        writer.Write(&looping, 1);
+        writer.Write(packed.GetTracks());
+        writer.Write(packed.GetGroupOffsets(), PACKED_CLIP_NUM_GROUPS + 1);
+        const unsigned int sections[3] = { packed.GetNumTimes(), packed.GetNumValues(), packed.GetNumTangents() };
+        writer.Write(sections, 3);
+        writer.Write(packed.GetData(), packed.GetDataSize() / sizeof(float));
+    }
+
+    if (!writer.Save(path))
+    {
+        std::cout << "Could not write cooked asset: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+CookedAsset::CookedAsset()
+{
+    mMapping = nullptr;
+    mMappedSize = 0;
+}
+
+CookedAsset::~CookedAsset()
+{
+    Unload();
+}
+
+bool CookedAsset::Load(const char* path, const CookedAssetSource& source)
+{
+    Unload();
+    if (!MapFile(path))
+    {
+        return false;
+    }
+
+    CookedAssetHelpers::Reader reader(mMapping, mMappedSize);
+    const CookedAssetHelpers::Header header = reader.ReadValue<CookedAssetHelpers::Header>();
+    if (!reader.IsValid() || header.mMagic != COOKED_ASSET_MAGIC || header.mVersion != COOKED_ASSET_VERSION)
+    {
+        std::cout << "Not a version " << COOKED_ASSET_VERSION << " cooked asset: " << path << "\n";
+        Unload();
+        return false;
+    }
+    if (!CookedAssetHelpers::MatchesSource(header, source))
+    {
+        std::cout << "Cooked asset is older than its source or reduction settings: " << path << "\n";
+        Unload();
+        return false;
+    }
+
+    // Every mesh and clip record spans several 16 byte aligned fields, so larger counts can only
+    // come from a corrupt header. Reserving up front keeps the clip views from being copied.
+    bool valid = header.mNumMeshes <= mMappedSize / 16 && header.mNumClips <= mMappedSize / 16;
+    if (valid)
+    {
+        mMeshes.reserve(header.mNumMeshes);
+        mClips.reserve(header.mNumClips);
+    }
+    Pose restPose;
+    Pose bindPose;
+    valid = valid && CookedAssetHelpers::ReadPose(reader, header.mNumJoints, restPose) &&
+        CookedAssetHelpers::ReadPose(reader, header.mNumJoints, bindPose);
+    std::vector<std::string> names;
+    for (unsigned int i = 0; i < header.mNumJoints && valid && reader.IsValid(); ++i)
+    {
+        names.push_back(reader.ReadString());
+    }
+    if (valid && reader.IsValid())
+    {
+        mSkeleton.Set(restPose, bindPose, names);
+    }
+
+    for (unsigned int i = 0; i < header.mNumMeshes && valid && reader.IsValid(); ++i)
+    {
+        mMeshes.emplace_back();
+        Mesh& mesh = mMeshes[i];
+        reader.ReadVector(mesh.GetPosition());
+        reader.ReadVector(mesh.GetNormal());
+        reader.ReadVector(mesh.GetTexCoord());
+        reader.ReadVector(mesh.GetWeights());
+        reader.ReadVector(mesh.GetInfluences());
+        reader.ReadVector(mesh.GetIndices());
+        reader.ReadVector(mesh.GetSkinJoints());
+        valid = CookedAssetHelpers::ValidMesh(mesh, header.mNumJoints);
+    }
+
+    std::vector<PackedTrack> tracks;
+    for (unsigned int i = 0; i < header.mNumClips && valid && reader.IsValid(); ++i)
+    {
+        std::string name = reader.ReadString();
+        const float* timeRange = reader.Read<float>(2);
+        const unsigned int looping = reader.ReadValue<unsigned int>();
+        reader.ReadVector(tracks);
+        const unsigned int* groupOffsets = reader.Read<unsigned int>(PACKED_CLIP_NUM_GROUPS + 1);
+        const unsigned int* sections = reader.Read<unsigned int>(3);
+        if (!reader.IsValid())
+        {
+            break;
+        }
+        valid = CookedAssetHelpers::ValidTracks(tracks, groupOffsets, sections, header.mNumJoints);
+        const unsigned long long numFloats = static_cast<unsigned long long>(sections[0]) + sections[1] +
+            2ull * sections[2];
+        if (!valid || numFloats > mMappedSize / sizeof(float))
+        {
+            valid = false;
+            break;
+        }
+        const float* data = reader.Read<float>(static_cast<size_t>(numFloats));
+        if (data == nullptr)
+        {
+            break;
+        }
+        mClips.emplace_back();
+        PackedClip& clip = mClips[i];
+        clip.GetName() = name;
+        clip.SetView(tracks, groupOffsets, data, sections[0], sections[1], sections[2]);
+        clip.SetTimeRange(timeRange[0], timeRange[1]);
+        clip.SetLooping(looping != 0);
+    }
+
+    if (!valid || !reader.IsValid())
+    {
+        std::cout << (reader.IsValid() ? "Corrupt" : "Truncated") << " cooked asset: " << path << "\n";
+        Unload();
+        return false;
+    }
+    return true;
+}
+
+void CookedAsset::Unload()
+{
+    // Clips point into the mapping, they go first
+    mClips.clear();
+    mMeshes.clear();
+    mSkeleton = Skeleton();
+    UnmapFile();
+}
+
+Skeleton& CookedAsset::GetSkeleton()
+{
+    return mSkeleton;
+}
+
+std::vector<Mesh>& CookedAsset::GetMeshes()
+{
+    return mMeshes;
+}
+
+std::vector<PackedClip>& CookedAsset::GetClips()
+{
+    return mClips;
+}
+
+#ifdef _WIN32
+bool GetCookedAssetSource(const char* sourcePath, const KeyReductionSettings& reduction,
+                          CookedAssetSource& outSource)
+{
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    if (!GetFileAttributesExA(sourcePath, GetFileExInfoStandard, &info))
+    {
+        return false;
+    }
+    outSource.mSize = (static_cast<unsigned long long>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    outSource.mWriteTime = (static_cast<unsigned long long>(info.ftLastWriteTime.dwHighDateTime) << 32) |
+        info.ftLastWriteTime.dwLowDateTime;
+    outSource.mReduction = reduction;
+    return true;
+}
+
+bool CookedAsset::MapFile(const char* path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+    {
+        return false;
+    }
+    // The view keeps the mapping alive after its handle is closed
+    mMapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (mMapping == nullptr)
+    {
+        return false;
+    }
+    mMappedSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void CookedAsset::UnmapFile()
+{
+    if (mMapping != nullptr)
+    {
+        UnmapViewOfFile(mMapping);
+    }
+    mMapping = nullptr;
+    mMappedSize = 0;
+}
+#else
+bool GetCookedAssetSource(const char* sourcePath, const KeyReductionSettings& reduction,
+                          CookedAssetSource& outSource)
+{
+    struct stat info;
+    if (stat(sourcePath, &info) != 0)
+    {
+        return false;
+    }
+    outSource.mSize = static_cast<unsigned long long>(info.st_size);
+    outSource.mWriteTime = static_cast<unsigned long long>(info.st_mtime);
+    outSource.mReduction = reduction;
+    return true;
+}
+
+bool CookedAsset::MapFile(const char* path)
+{
+    const int file = open(path, O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    mMapping = mapping;
+    mMappedSize = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void CookedAsset::UnmapFile()
+{
+    if (mMapping != nullptr)
+    {
+        munmap(mMapping, mMappedSize);
+    }
+    mMapping = nullptr;
+    mMappedSize = 0;
+}
+#endif
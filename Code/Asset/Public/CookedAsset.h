@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "Animation/Public/Skeleton.h"
+#include "Animation/Public/Clip.h"
+#include "Animation/Public/PackedClip.h"
+#include "Animation/Public/KeyReduction.h"
+#include "Rendering/Public/Mesh.h"
+
+// "COOK" read as a little endian unsigned int
+#define COOKED_ASSET_MAGIC 0x4B4F4F43
+// Bump whenever the layout below changes, files with another version are rejected
+#define COOKED_ASSET_VERSION 2
+
+// What a cooked file was built from. A file cooked from another version of the source, or with
+// other key reduction tolerances, is stale and has to be cooked again.
+struct CookedAssetSource
+{
+    unsigned long long mSize;
+    unsigned long long mWriteTime;
+    KeyReductionSettings mReduction;
+};
+
+// Size and last write time of the source file, returns false if it can't be found
+bool GetCookedAssetSource(const char* sourcePath, const KeyReductionSettings& reduction,
+                          CookedAssetSource& outSource);
+
+// Writes the skeleton, the mesh vertex and index streams and the clips, packed with PackClip,
+// into one binary file that CookedAsset loads without parsing. Every array starts on a 16 byte
+// boundary, so mapped clip data can be sampled in place. Returns false if the file can't be written.
+bool CookAsset(const char* path, const CookedAssetSource& source, Skeleton& skeleton, std::vector<Mesh>& meshes,
+               std::vector<Clip>& clips);
+
+// A cooked file mapped into memory. The clips sample their keys straight from the mapped pages,
+// so the asset has to outlive them, copies of a clip own their keys. Meshes copy each vertex
+// stream out in one go and come back as CPU data, like GLTFImporter's, the caller uploads them.
+// Everything the samplers and skinning index with is range checked before it is used.
+class CookedAsset
+{
+protected:
+    void* mMapping;
+    size_t mMappedSize;
+    Skeleton mSkeleton;
+    std::vector<Mesh> mMeshes;
+    std::vector<PackedClip> mClips;
+
+    bool MapFile(const char* path);
+    void UnmapFile();
+private:
+    CookedAsset(const CookedAsset&);
+    CookedAsset& operator=(const CookedAsset&);
+public:
+    CookedAsset();
+    ~CookedAsset();
+
+    // Returns false and leaves the asset empty when the file is missing, stale, truncated, corrupt
+    // or of another version. Only a missing file is not reported, it just hasn't been cooked yet.
+    bool Load(const char* path, const CookedAssetSource& source);
+    void Unload();
+
+    Skeleton& GetSkeleton();
+    std::vector<Mesh>& GetMeshes();
+    std::vector<PackedClip>& GetClips();
+};
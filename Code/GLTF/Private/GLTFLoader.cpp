@@ -4,9 +4,18 @@
 #include <iostream>
 #include "Math/Public/Transform.h"
 #include <algorithm>
+#include <cstring>
+#include <chrono>
 
 namespace GLTFHelpers
 {
+    typedef std::chrono::steady_clock ImportClock;
+
+    float MillisecondsSince(ImportClock::time_point start)
+    {
+        return std::chrono::duration<float, std::milli>(ImportClock::now() - start).count();
+    }
+
     Transform GetLocalTransform(cgltf_node& node)
     {
         Transform result;
@@ -35,31 +44,181 @@ namespace GLTFHelpers
         return result;
     }
 
+    // cgltf keeps every node in one array, so the index is the pointer's offset into it
     int GetNodeIndex(cgltf_node* target, cgltf_node* allNodes, unsigned int numNodes)
     {
-        if (target == nullptr)
+        if (target == nullptr || target < allNodes || target >= allNodes + numNodes)
         {
             return -1;
         }
+        return static_cast<int>(target - allNodes);
+    }
+
+    // Node index to joint index, ordered so every joint comes after its parent. Nodes that are
+    // already in that order keep their index.
+    std::vector<int> GetJointRemap(cgltf_data* data)
+    {
+        const unsigned int numNodes = static_cast<unsigned>(data->nodes_count);
+        std::vector<int> result(numNodes, -1);
+        std::vector<unsigned int> chain;
+        int nextJoint = 0;
+
         for (unsigned int i = 0; i < numNodes; ++i)
         {
-            if (target == &allNodes[i])
+            // Number the unvisited ancestors first, root most ancestor first
+            chain.clear();
+            for (int node = static_cast<int>(i); node >= 0 && result[node] < 0;
+                 node = GetNodeIndex(data->nodes[node].parent, data->nodes, numNodes))
             {
-                return static_cast<int>(i);
+                chain.push_back(static_cast<unsigned>(node));
             }
+            for (unsigned int j = static_cast<unsigned>(chain.size()); j > 0; --j)
+            {
+                result[chain[j - 1]] = nextJoint++;
+            }
+        }
+
+        return result;
+    }
+
+    int GetJointIndex(cgltf_node* target, cgltf_data* data, const std::vector<int>& remap)
+    {
+        const int node = GetNodeIndex(target, data->nodes, static_cast<unsigned>(data->nodes_count));
+        return node < 0 ? -1 : remap[node];
+    }
+
+    // Joint index of every joint in the skin, in the skin's order. Mesh influences index this table.
+    std::vector<unsigned int> GetSkinJoints(cgltf_skin* skin, cgltf_data* data, const std::vector<int>& remap)
+    {
+        const unsigned int numJoints = static_cast<unsigned>(skin->joints_count);
+        std::vector<unsigned int> result(numJoints);
+        for (unsigned int i = 0; i < numJoints; ++i)
+        {
+            result[i] = static_cast<unsigned>(std::max(0, GetJointIndex(skin->joints[i], data, remap)));
+        }
+        return result;
+    }
+
+    // Start of the accessor's data when its elements are tightly packed and need no conversion
+    // beyond a cast, null when they have to be read one at a time through cgltf
+    const unsigned char* GetPackedData(const cgltf_accessor& accessor, cgltf_size componentSize,
+                                       unsigned int componentCount)
+    {
+        if (accessor.is_sparse || accessor.normalized || accessor.buffer_view == nullptr ||
+            accessor.buffer_view->buffer->data == nullptr ||
+            cgltf_num_components(accessor.type) != componentCount ||
+            accessor.stride != componentSize * componentCount)
+        {
+            return nullptr;
+        }
+        return static_cast<const unsigned char*>(accessor.buffer_view->buffer->data) +
+            accessor.buffer_view->offset + accessor.offset;
+    }
+
+    // One loop over the whole buffer, simple enough for the compiler to vectorize
+    template <typename IN, typename OUT>
+    void ConvertPacked(const unsigned char* data, OUT* out, cgltf_size count)
+    {
+        const IN* in = reinterpret_cast<const IN*>(data);
+        for (cgltf_size i = 0; i < count; ++i)
+        {
+            out[i] = static_cast<OUT>(in[i]);
         }
-        return -1;
     }
 
     void GetScalarValues(std::vector<float>& outScalars, unsigned int inComponentCount, const cgltf_accessor& inAccessor)
     {
-        outScalars.resize(inAccessor.count * inComponentCount);
+        const cgltf_size numScalars = inAccessor.count * inComponentCount;
+        outScalars.resize(numScalars);
+        if (numScalars == 0)
+        {
+            return;
+        }
+
+        const unsigned char* packed = nullptr;
+        switch (inAccessor.component_type)
+        {
+        case cgltf_component_type_r_32f:
+            packed = GetPackedData(inAccessor, sizeof(float), inComponentCount);
+            if (packed != nullptr)
+            {
+                memcpy(&outScalars[0], packed, numScalars * sizeof(float));
+                return;
+            }
+            break;
+        case cgltf_component_type_r_16u:
+            packed = GetPackedData(inAccessor, sizeof(unsigned short), inComponentCount);
+            if (packed != nullptr)
+            {
+                ConvertPacked<unsigned short>(packed, &outScalars[0], numScalars);
+                return;
+            }
+            break;
+        case cgltf_component_type_r_8u:
+            packed = GetPackedData(inAccessor, sizeof(unsigned char), inComponentCount);
+            if (packed != nullptr)
+            {
+                ConvertPacked<unsigned char>(packed, &outScalars[0], numScalars);
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+
+        // Strided, normalized, sparse or other component types
         for (cgltf_size i = 0; i < inAccessor.count; ++i)
         {
             cgltf_accessor_read_float(&inAccessor, i, &outScalars[i * inComponentCount], inComponentCount);
         }
     }
 
+    void GetIndexValues(std::vector<unsigned int>& outIndices, const cgltf_accessor& inAccessor)
+    {
+        const cgltf_size count = inAccessor.count;
+        outIndices.resize(count);
+        if (count == 0)
+        {
+            return;
+        }
+
+        const unsigned char* packed = nullptr;
+        switch (inAccessor.component_type)
+        {
+        case cgltf_component_type_r_32u:
+            packed = GetPackedData(inAccessor, sizeof(unsigned int), 1);
+            if (packed != nullptr)
+            {
+                memcpy(&outIndices[0], packed, count * sizeof(unsigned int));
+                return;
+            }
+            break;
+        case cgltf_component_type_r_16u:
+            packed = GetPackedData(inAccessor, sizeof(unsigned short), 1);
+            if (packed != nullptr)
+            {
+                ConvertPacked<unsigned short>(packed, &outIndices[0], count);
+                return;
+            }
+            break;
+        case cgltf_component_type_r_8u:
+            packed = GetPackedData(inAccessor, sizeof(unsigned char), 1);
+            if (packed != nullptr)
+            {
+                ConvertPacked<unsigned char>(packed, &outIndices[0], count);
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+
+        for (cgltf_size i = 0; i < count; ++i)
+        {
+            outIndices[i] = static_cast<unsigned>(cgltf_accessor_read_index(&inAccessor, i));
+        }
+    }
+
     template <typename T, int N>
     void TrackFromChannel(Track<T, N>& inOutTrack, const cgltf_animation_channel& inChannel)
     {
@@ -111,8 +270,7 @@ namespace GLTFHelpers
         }
     }
 
-    void MeshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute, cgltf_skin* skin, cgltf_node* nodes,
-                           unsigned int nodeCount)
+    void MeshFromAttribute(Mesh& outMesh, cgltf_attribute& attribute)
     {
         cgltf_attribute_type attribType = attribute.type;
         cgltf_accessor& accessor = *attribute.data;
@@ -166,8 +324,8 @@ namespace GLTFHelpers
                 break;
             case cgltf_attribute_type_joints:
                 {
-                    // These indices are skin relative. This function has no information about the
-                    // skin that is being parsed. Add +0.5f to round, since we can't read ints
+                    // These indices are skin relative and stay that way, the mesh's skin joint
+                    // table maps them to the pose. Add +0.5f to round, since we can't read ints
                     IVec4 joints(
                         values[index + 0] + 0.5f,
                         values[index + 1] + 0.5f,
@@ -175,17 +333,258 @@ namespace GLTFHelpers
                         values[index + 3] + 0.5f
                     );
 
-                    joints.x = std::max(0, GetNodeIndex(skin->joints[joints.x], nodes, nodeCount));
-                    joints.y = std::max(0, GetNodeIndex(skin->joints[joints.y], nodes, nodeCount));
-                    joints.z = std::max(0, GetNodeIndex(skin->joints[joints.z], nodes, nodeCount));
-                    joints.w = std::max(0, GetNodeIndex(skin->joints[joints.w], nodes, nodeCount));
-
                     influences.push_back(joints);
                 }
                 break;
             } // End switch statement
         }
     } // End of MeshFromAttribute function
+
+    Pose BuildRestPose(cgltf_data* data, const std::vector<int>& remap)
+    {
+        unsigned int boneCount = static_cast<unsigned>(data->nodes_count);
+        Pose result(boneCount);
+
+        for (unsigned int i = 0; i < boneCount; ++i)
+        {
+            cgltf_node* node = &(data->nodes[i]);
+
+            Transform transform = GetLocalTransform(data->nodes[i]);
+            result.SetLocalTransform(remap[i], transform);
+
+            int parent = GetJointIndex(node->parent, data, remap);
+            result.SetParent(remap[i], parent);
+        }
+
+        return result;
+    }
+
+    std::vector<Transform> BuildWorldPose(const Pose& pose)
+    {
+        unsigned int numBones = pose.Size();
+        std::vector<Transform> result(numBones);
+        for (unsigned int i = 0; i < numBones; ++i)
+        {
+            result[i] = pose.GetGlobalTransform(i);
+        }
+        return result;
+    }
+
+    std::vector<std::string> BuildJointNames(cgltf_data* data, const std::vector<int>& remap)
+    {
+        unsigned int boneCount = static_cast<unsigned>(data->nodes_count);
+        std::vector<std::string> result(boneCount, "Not Set");
+
+        for (unsigned int i = 0; i < boneCount; ++i)
+        {
+            cgltf_node* node = &(data->nodes[i]);
+
+            if (node->name == nullptr)
+            {
+                result[remap[i]] = "EMPTY NODE";
+            }
+            else
+            {
+                result[remap[i]] = node->name;
+            }
+        }
+
+        return result;
+    }
+
+    // Reads only the file and the rest pose, animations can be built on several threads at once
+    ConstantTrackStats ClipFromAnimation(Clip& outClip, cgltf_data* data, unsigned int index,
+                                         const std::vector<int>& remap, const Pose& restPose)
+    {
+        outClip.SetName(data->animations[index].name);
+
+        unsigned int numChannels = static_cast<unsigned>(data->animations[index].channels_count);
+        for (unsigned int j = 0; j < numChannels; ++j)
+        {
+            cgltf_animation_channel& channel = data->animations[index].channels[j];
+            cgltf_node* target = channel.target_node;
+            int nodeId = GetJointIndex(target, data, remap);
+            if (channel.target_path == cgltf_animation_path_type_translation)
+            {
+                VectorTrack& track = outClip[nodeId].GetPositionTrack();
+                TrackFromChannel<Vec3, 3>(track, channel);
+            }
+            else if (channel.target_path == cgltf_animation_path_type_scale)
+            {
+                VectorTrack& track = outClip[nodeId].GetScaleTrack();
+                TrackFromChannel<Vec3, 3>(track, channel);
+            }
+            else if (channel.target_path == cgltf_animation_path_type_rotation)
+            {
+                QuaternionTrack& track = outClip[nodeId].GetRotationTrack();
+                TrackFromChannel<Quat, 4>(track, channel);
+            }
+        }
+        outClip.RecalculateDuration();
+        // Also finds the timelines the channels share
+        return StripConstantTracks(outClip, restPose);
+    }
+
+    std::vector<Clip> BuildAnimationClips(cgltf_data* data, const std::vector<int>& remap, Pose& restPose)
+    {
+        unsigned int numClips = static_cast<unsigned>(data->animations_count);
+        std::vector<Clip> result;
+        result.resize(numClips);
+
+        for (unsigned int i = 0; i < numClips; ++i)
+        {
+            ClipFromAnimation(result[i], data, i, remap, restPose);
+        }
+
+        return result;
+    }
+
+    // worldRestPose is the rest pose in world space, joints no skin binds keep it
+    Pose BuildBindPose(cgltf_data* data, const std::vector<int>& remap, const Pose& restPose,
+                       const std::vector<Transform>& worldRestPose)
+    {
+        unsigned int numBones = restPose.Size();
+        std::vector<Transform> worldBindPose = worldRestPose;
+        unsigned int numSkins = static_cast<unsigned>(data->skins_count);
+        for (unsigned int i = 0; i < numSkins; ++i)
+        {
+            cgltf_skin* skin = &(data->skins[i]);
+            std::vector<float> invBindAccessor;
+            GetScalarValues(invBindAccessor, 16, *skin->inverse_bind_matrices);
+
+            unsigned int numJoints = static_cast<unsigned>(skin->joints_count);
+            for (unsigned int j = 0; j < numJoints; ++j)
+            {
+                // Read the ivnerse bind matrix of the joint
+                float* matrix = &(invBindAccessor[j * 16]);
+                auto invBindMatrix = Mat4(matrix);
+                // invert, convert to transform
+                Mat4 bindMatrix = invBindMatrix.Inverse();
+                Transform bindTransform = bindMatrix.ToTransform();
+                // Set that transform in the worldBindPose.
+                cgltf_node* jointNode = skin->joints[j];
+                int jointIndex = GetJointIndex(jointNode, data, remap);
+                worldBindPose[jointIndex] = bindTransform;
+            } // end for each joint
+        } // end for each skin
+        // Convert the world bind pose to a regular bind pose
+        Pose bindPose = restPose;
+        for (unsigned int i = 0; i < numBones; ++i)
+        {
+            Transform current = worldBindPose[i];
+            int p = bindPose.GetParent(i);
+            if (p >= 0)
+            {
+                // Bring into parent space
+                Transform parent = worldBindPose[p];
+                current = Transform::Combine(parent.Inverse(), current);
+            }
+            bindPose.SetLocalTransform(i, current);
+        }
+
+        return bindPose;
+    } // End BuildBindPose function
+
+    // A primitive of a skinned mesh node, each one becomes a Mesh
+    struct SkinnedPrimitive
+    {
+        const cgltf_node* mNode;
+        const cgltf_primitive* mPrimitive;
+    };
+
+    std::vector<SkinnedPrimitive> FindSkinnedPrimitives(cgltf_data* data)
+    {
+        std::vector<SkinnedPrimitive> result;
+        cgltf_node* nodes = data->nodes;
+        const unsigned int nodeCount = static_cast<unsigned>(data->nodes_count);
+
+        for (unsigned int i = 0; i < nodeCount; ++i)
+        {
+            const cgltf_node* node = &nodes[i];
+            if (node->mesh == nullptr || node->skin == nullptr)
+            {
+                continue;
+            }
+            const unsigned int numPrims = static_cast<unsigned>(node->mesh->primitives_count);
+            for (unsigned int j = 0; j < numPrims; ++j)
+            {
+                SkinnedPrimitive primitive;
+                primitive.mNode = node;
+                primitive.mPrimitive = &node->mesh->primitives[j];
+                result.push_back(primitive);
+            }
+        }
+
+        return result;
+    }
+
+    // CPU side only, no GL calls, so primitives can be decoded on several threads at once
+    void MeshFromPrimitive(Mesh& outMesh, const SkinnedPrimitive& source, cgltf_data* data,
+                           const std::vector<int>& remap)
+    {
+        const cgltf_primitive* primitive = source.mPrimitive;
+        const unsigned int numAttributes = static_cast<unsigned>(primitive->attributes_count);
+        for (unsigned int k = 0; k < numAttributes; ++k)
+        {
+            cgltf_attribute* attribute = &primitive->attributes[k];
+            MeshFromAttribute(outMesh, *attribute);
+        }
+        outMesh.GetSkinJoints() = GetSkinJoints(source.mNode->skin, data, remap);
+        if (primitive->indices != nullptr)
+        {
+            GetIndexValues(outMesh.GetIndices(), *primitive->indices);
+        }
+    }
+
+    std::vector<Mesh> BuildMeshes(cgltf_data* data, const std::vector<int>& remap)
+    {
+        std::vector<SkinnedPrimitive> primitives = FindSkinnedPrimitives(data);
+        const unsigned int numMeshes = static_cast<unsigned>(primitives.size());
+        std::vector<Mesh> result(numMeshes);
+
+        for (unsigned int i = 0; i < numMeshes; ++i)
+        {
+            MeshFromPrimitive(result[i], primitives[i], data, remap);
+            result[i].UpdateOpenGLBuffers();
+        }
+
+        return result;
+    } // End of the BuildMeshes function
+
+    // Shared by the serial and the pooled import. Tasks [0, numMeshes) decode one primitive each,
+    // the rest one animation each. Every task writes only its own mesh or clip and task time.
+    struct ImportTasks
+    {
+        cgltf_data* mData;
+        const std::vector<int>* mRemap;
+        Pose* mRestPose;
+        const std::vector<SkinnedPrimitive>* mPrimitives;
+        std::vector<Mesh>* mMeshes;
+        std::vector<Clip>* mClips;
+        std::vector<float> mTaskTimes;
+        std::vector<ConstantTrackStats> mConstantTracks;
+    };
+
+    void RunImportTasks(void* context, unsigned int begin, unsigned int end)
+    {
+        ImportTasks* tasks = static_cast<ImportTasks*>(context);
+        const unsigned int numMeshes = static_cast<unsigned>(tasks->mMeshes->size());
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            const ImportClock::time_point start = ImportClock::now();
+            if (i < numMeshes)
+            {
+                MeshFromPrimitive((*tasks->mMeshes)[i], (*tasks->mPrimitives)[i], tasks->mData, *tasks->mRemap);
+            }
+            else
+            {
+                tasks->mConstantTracks[i - numMeshes] = ClipFromAnimation((*tasks->mClips)[i - numMeshes],
+                                                                          tasks->mData, i - numMeshes,
+                                                                          *tasks->mRemap, *tasks->mRestPose);
+            }
+            tasks->mTaskTimes[i] = MillisecondsSince(start);
+        }
+    }
 } // End of GLTFHelpers
 
 cgltf_data* LoadGLTFFile(const char* path)
@@ -230,133 +629,32 @@ void FreeGLTFFile(cgltf_data* data)
 
 Pose LoadRestPose(cgltf_data* data)
 {
-    unsigned int boneCount = static_cast<unsigned>(data->nodes_count);
-    Pose result(boneCount);
-
-    for (unsigned int i = 0; i < boneCount; ++i)
-    {
-        cgltf_node* node = &(data->nodes[i]);
-
-        Transform transform = GLTFHelpers::GetLocalTransform(data->nodes[i]);
-        result.SetLocalTransform(i, transform);
-
-        int parent = GLTFHelpers::GetNodeIndex(node->parent, data->nodes, boneCount);
-        result.SetParent(i, parent);
-    }
-
-    return result;
+    return GLTFHelpers::BuildRestPose(data, GLTFHelpers::GetJointRemap(data));
 }
 
 std::vector<std::string> LoadJointNames(cgltf_data* data)
 {
-    unsigned int boneCount = static_cast<unsigned>(data->nodes_count);
-    std::vector<std::string> result(boneCount, "Not Set");
-
-    for (unsigned int i = 0; i < boneCount; ++i)
-    {
-        cgltf_node* node = &(data->nodes[i]);
-
-        if (node->name == nullptr)
-        {
-            result[i] = "EMPTY NODE";
-        }
-        else
-        {
-            result[i] = node->name;
-        }
-    }
+    return GLTFHelpers::BuildJointNames(data, GLTFHelpers::GetJointRemap(data));
+}
 
-    return result;
+std::vector<int> LoadJointRemap(cgltf_data* data)
+{
+    return GLTFHelpers::GetJointRemap(data);
 }
 
 std::vector<Clip> LoadAnimationClips(cgltf_data* data)
 {
-    unsigned int numClips = static_cast<unsigned>(data->animations_count);
-    unsigned int numNodes = static_cast<unsigned>(data->nodes_count);
-
-    std::vector<Clip> result;
-    result.resize(numClips);
-
-    for (unsigned int i = 0; i < numClips; ++i)
-    {
-        result[i].SetName(data->animations[i].name);
-
-        unsigned int numChannels = static_cast<unsigned>(data->animations[i].channels_count);
-        for (unsigned int j = 0; j < numChannels; ++j)
-        {
-            cgltf_animation_channel& channel = data->animations[i].channels[j];
-            cgltf_node* target = channel.target_node;
-            int nodeId = GLTFHelpers::GetNodeIndex(target, data->nodes, numNodes);
-            if (channel.target_path == cgltf_animation_path_type_translation)
-            {
-                VectorTrack& track = result[i][nodeId].GetPositionTrack();
-                GLTFHelpers::TrackFromChannel<Vec3, 3>(track, channel);
-            }
-            else if (channel.target_path == cgltf_animation_path_type_scale)
-            {
-                VectorTrack& track = result[i][nodeId].GetScaleTrack();
-                GLTFHelpers::TrackFromChannel<Vec3, 3>(track, channel);
-            }
-            else if (channel.target_path == cgltf_animation_path_type_rotation)
-            {
-                QuaternionTrack& track = result[i][nodeId].GetRotationTrack();
-                GLTFHelpers::TrackFromChannel<Quat, 4>(track, channel);
-            }
-        }
-        result[i].RecalculateDuration();
-    }
-
-    return result;
+    std::vector<int> remap = GLTFHelpers::GetJointRemap(data);
+    Pose restPose = GLTFHelpers::BuildRestPose(data, remap);
+    return GLTFHelpers::BuildAnimationClips(data, remap, restPose);
 }
 
 Pose LoadBindPose(cgltf_data* data)
 {
-    Pose restPose = LoadRestPose(data);
-    unsigned int numBones = restPose.Size();
-    std::vector<Transform> worldBindPose(numBones);
-    for (unsigned int i = 0; i < numBones; ++i)
-    {
-        worldBindPose[i] = restPose.GetGlobalTransform(i);
-    }
-    unsigned int numSkins = static_cast<unsigned>(data->skins_count);
-    for (unsigned int i = 0; i < numSkins; ++i)
-    {
-        cgltf_skin* skin = &(data->skins[i]);
-        std::vector<float> invBindAccessor;
-        GLTFHelpers::GetScalarValues(invBindAccessor, 16, *skin->inverse_bind_matrices);
-
-        unsigned int numJoints = static_cast<unsigned>(skin->joints_count);
-        for (unsigned int j = 0; j < numJoints; ++j)
-        {
-            // Read the ivnerse bind matrix of the joint
-            float* matrix = &(invBindAccessor[j * 16]);
-            auto invBindMatrix = Mat4(matrix);
-            // invert, convert to transform
-            Mat4 bindMatrix = invBindMatrix.Inverse();
-            Transform bindTransform = bindMatrix.ToTransform();
-            // Set that transform in the worldBindPose.
-            cgltf_node* jointNode = skin->joints[j];
-            int jointIndex = GLTFHelpers::GetNodeIndex(jointNode, data->nodes, numBones);
-            worldBindPose[jointIndex] = bindTransform;
-        } // end for each joint
-    } // end for each skin
-    // Convert the world bind pose to a regular bind pose
-    Pose bindPose = restPose;
-    for (unsigned int i = 0; i < numBones; ++i)
-    {
-        Transform current = worldBindPose[i];
-        int p = bindPose.GetParent(i);
-        if (p >= 0)
-        {
-            // Bring into parent space
-            Transform parent = worldBindPose[p];
-            current = Transform::Combine(parent.Inverse(), current);
-        }
-        bindPose.SetLocalTransform(i, current);
-    }
-
-    return bindPose;
-} // End LoadBindPose function
+    std::vector<int> remap = GLTFHelpers::GetJointRemap(data);
+    Pose restPose = GLTFHelpers::BuildRestPose(data, remap);
+    return GLTFHelpers::BuildBindPose(data, remap, restPose, GLTFHelpers::BuildWorldPose(restPose));
+}
 
 Skeleton LoadSkeleton(cgltf_data* data)
 {
@@ -369,45 +667,127 @@ Skeleton LoadSkeleton(cgltf_data* data)
 
 std::vector<Mesh> LoadMeshes(cgltf_data* data)
 {
-    std::vector<Mesh> result;
-    cgltf_node* nodes = data->nodes;
-    const unsigned int nodeCount = static_cast<unsigned>(data->nodes_count);
+    return GLTFHelpers::BuildMeshes(data, GLTFHelpers::GetJointRemap(data));
+}
+
+GLTFImporter::GLTFImporter()
+{
+}
+
+bool GLTFImporter::Import(cgltf_data* data)
+{
+    return ImportInternal(data, nullptr);
+}
+
+bool GLTFImporter::Import(cgltf_data* data, WorkerPool& pool)
+{
+    return ImportInternal(data, &pool);
+}
+
+bool GLTFImporter::ImportInternal(cgltf_data* data, WorkerPool* pool)
+{
+    mRemap.clear();
+    mRestPose = Pose();
+    mWorldRestPose.clear();
+    mSkeleton = Skeleton();
+    mMeshes.clear();
+    mClips.clear();
+    mStats = GLTFImportStats();
+    mConstantTracks = ConstantTrackStats();
+    if (data == nullptr)
+    {
+        std::cout << "WARNING: Can't import null data\n";
+        return false;
+    }
 
-    for (unsigned int i = 0; i < nodeCount; ++i)
+    const GLTFHelpers::ImportClock::time_point importStart = GLTFHelpers::ImportClock::now();
+    GLTFHelpers::ImportClock::time_point stageStart = importStart;
+    mRemap = GLTFHelpers::GetJointRemap(data);
+    mRestPose = GLTFHelpers::BuildRestPose(data, mRemap);
+    mWorldRestPose = GLTFHelpers::BuildWorldPose(mRestPose);
+    mStats.mNodes = GLTFHelpers::MillisecondsSince(stageStart);
+
+    stageStart = GLTFHelpers::ImportClock::now();
+    mSkeleton.Set(
+        mRestPose,
+        GLTFHelpers::BuildBindPose(data, mRemap, mRestPose, mWorldRestPose),
+        GLTFHelpers::BuildJointNames(data, mRemap)
+    );
+    mStats.mSkeleton = GLTFHelpers::MillisecondsSince(stageStart);
+
+    // Primitives and animations don't depend on each other, decode them all before any GL work
+    stageStart = GLTFHelpers::ImportClock::now();
+    std::vector<GLTFHelpers::SkinnedPrimitive> primitives = GLTFHelpers::FindSkinnedPrimitives(data);
+    const unsigned int numMeshes = static_cast<unsigned>(primitives.size());
+    const unsigned int numClips = static_cast<unsigned>(data->animations_count);
+    mMeshes.resize(numMeshes);
+    mClips.resize(numClips);
+
+    GLTFHelpers::ImportTasks tasks;
+    tasks.mData = data;
+    tasks.mRemap = &mRemap;
+    tasks.mRestPose = &mRestPose;
+    tasks.mPrimitives = &primitives;
+    tasks.mMeshes = &mMeshes;
+    tasks.mClips = &mClips;
+    tasks.mTaskTimes.resize(numMeshes + numClips);
+    tasks.mConstantTracks.resize(numClips);
+    if (pool != nullptr)
     {
-        const cgltf_node* node = &nodes[i];
-        if (node->mesh == nullptr || node->skin == nullptr)
+        // One task per chunk, a single large primitive or clip shouldn't hold others back
+        pool->ParallelFor(numMeshes + numClips, 1, GLTFHelpers::RunImportTasks, &tasks);
+    }
+    else
+    {
+        GLTFHelpers::RunImportTasks(&tasks, 0, numMeshes + numClips);
+    }
+    for (unsigned int i = 0; i < numMeshes + numClips; ++i)
+    {
+        if (i < numMeshes)
         {
-            continue;
+            mStats.mMeshes += tasks.mTaskTimes[i];
         }
-        const unsigned int numPrims = static_cast<unsigned>(node->mesh->primitives_count);
-        for (unsigned int j = 0; j < numPrims; ++j)
+        else
         {
-            result.emplace_back();
-            Mesh& mesh = result[result.size() - 1];
+            mStats.mClips += tasks.mTaskTimes[i];
+            const ConstantTrackStats& clipTracks = tasks.mConstantTracks[i - numMeshes];
+            mConstantTracks.mCollapsed += clipTracks.mCollapsed;
+            mConstantTracks.mRemoved += clipTracks.mRemoved;
+            mConstantTracks.mJointsRemoved += clipTracks.mJointsRemoved;
+        }
+    }
+    mStats.mDecode = GLTFHelpers::MillisecondsSince(stageStart);
 
-            const cgltf_primitive* primitive = &node->mesh->primitives[j];
+    mStats.mTotal = GLTFHelpers::MillisecondsSince(importStart);
+    return true;
+}
 
-            const unsigned int numAttributes = static_cast<unsigned>(primitive->attributes_count);
-            for (unsigned int k = 0; k < numAttributes; ++k)
-            {
-                cgltf_attribute* attribute = &primitive->attributes[k];
-                GLTFHelpers::MeshFromAttribute(mesh, *attribute, node->skin, nodes, nodeCount);
-            }
-            if (primitive->indices != nullptr)
-            {
-                const unsigned int indexCount = static_cast<unsigned>(primitive->indices->count);
-                std::vector<unsigned int>& indices = mesh.GetIndices();
-                indices.resize(indexCount);
+Skeleton& GLTFImporter::GetSkeleton()
+{
+    return mSkeleton;
+}
 
-                for (unsigned int k = 0; k < indexCount; ++k)
-                {
-                    indices[k] = static_cast<unsigned>(cgltf_accessor_read_index(primitive->indices, k));
-                }
-            }
-            mesh.UpdateOpenGLBuffers();
-        }
-    }
+std::vector<Mesh>& GLTFImporter::GetMeshes()
+{
+    return mMeshes;
+}
 
-    return result;
-} // End of the LoadMeshes function
+std::vector<Clip>& GLTFImporter::GetClips()
+{
+    return mClips;
+}
+
+std::vector<int>& GLTFImporter::GetJointRemap()
+{
+    return mRemap;
+}
+
+const GLTFImportStats& GLTFImporter::GetStats() const
+{
+    return mStats;
+}
+
+const ConstantTrackStats& GLTFImporter::GetConstantTrackStats() const
+{
+    return mConstantTracks;
+}
@@ -6,6 +6,7 @@
 #include "Animation/Public/Skeleton.h"
 #include "Rendering/Public/Mesh.h"
 #include "Animation/Public/Clip.h"
+#include "Threading/Public/WorkerPool.h"
 #include <vector>
 #include <string>
 
@@ -14,9 +15,60 @@ void FreeGLTFFile(cgltf_data* handle);
 
 Pose LoadRestPose(cgltf_data* data);
 std::vector<std::string> LoadJointNames(cgltf_data* data);
+// Node index to joint index. Joints are ordered so every joint comes after its parent.
+std::vector<int> LoadJointRemap(cgltf_data* data);
 std::vector<Clip> LoadAnimationClips(cgltf_data* data);
 Pose LoadBindPose(cgltf_data* data);
 Skeleton LoadSkeleton(cgltf_data* data);
 std::vector<Mesh> LoadMeshes(cgltf_data* data);
 
+// Milliseconds spent in each stage of the last GLTFImporter::Import. mMeshes and mClips add up
+// the time of every primitive and animation, with a pool they overlap inside mDecode.
+struct GLTFImportStats
+{
+    float mNodes;
+    float mSkeleton;
+    float mMeshes;
+    float mClips;
+    float mDecode;
+    float mTotal;
+
+    GLTFImportStats() : mNodes(0.0f), mSkeleton(0.0f), mMeshes(0.0f), mClips(0.0f), mDecode(0.0f),
+        mTotal(0.0f)
+    {
+    }
+};
+
+// Builds the skeleton, meshes and clips of a file in one pass. The Load functions above each
+// redo the node work, the importer does it once: the joint remap, the rest pose and its world
+// transforms are shared by every stage. Meshes come back as CPU data only, the caller uploads
+// the ones it draws with UpdateOpenGLBuffers on the thread that owns the context.
+class GLTFImporter
+{
+protected:
+    std::vector<int> mRemap;
+    Pose mRestPose;
+    std::vector<Transform> mWorldRestPose;
+    Skeleton mSkeleton;
+    std::vector<Mesh> mMeshes;
+    std::vector<Clip> mClips;
+    GLTFImportStats mStats;
+    ConstantTrackStats mConstantTracks;
+
+    bool ImportInternal(cgltf_data* data, WorkerPool* pool);
+public:
+    GLTFImporter();
+    // Returns false and leaves the importer empty when data is null
+    bool Import(cgltf_data* data);
+    // Decodes every primitive and animation as its own task on the pool, the calling thread helps
+    bool Import(cgltf_data* data, WorkerPool& pool);
+    Skeleton& GetSkeleton();
+    std::vector<Mesh>& GetMeshes();
+    std::vector<Clip>& GetClips();
+    std::vector<int>& GetJointRemap();
+    const GLTFImportStats& GetStats() const;
+    // Summed over every clip of the last Import
+    const ConstantTrackStats& GetConstantTrackStats() const;
+};
+
 #endif
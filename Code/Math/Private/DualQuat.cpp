@@ -0,0 +1,87 @@
+#include "Math/Public/DualQuat.h"
+#include <cmath>
+
+DualQuat DualQuat::FromTransform(const Transform& t)
+{
+    Quat d(t.position.x, t.position.y, t.position.z, 0);
+    Quat r = t.rotation.Normalized();
+    return DualQuat(r, (r * d) * 0.5f);
+}
+
+float DualQuat::Dot(const DualQuat& a, const DualQuat& b)
+{
+    return Quat::Dot(a.real, b.real);
+}
+
+Transform DualQuat::ToTransform() const
+{
+    Transform result;
+    result.rotation = real;
+    result.position = GetTranslation();
+    return result;
+}
+
+Vec3 DualQuat::GetTranslation() const
+{
+    Quat d = real.Conjugate() * (dual * 2.0f);
+    return Vec3(d.x, d.y, d.z);
+}
+
+Vec3 DualQuat::TransformPoint(const Vec3& v) const
+{
+    return real * v + GetTranslation();
+}
+
+Vec3 DualQuat::TransformVector(const Vec3& v) const
+{
+    return real * v;
+}
+
+void DualQuat::Normalize()
+{
+    float lenSq = real.LenSq();
+    if (lenSq < QUAT_EPSILON)
+    {
+        return;
+    }
+    float invLen = 1.0f / sqrtf(lenSq);
+    real = real * invLen;
+    dual = dual * invLen;
+}
+
+DualQuat DualQuat::Normalized() const
+{
+    DualQuat result = *this;
+    result.Normalize();
+    return result;
+}
+
+DualQuat DualQuat::Conjugate() const
+{
+    return DualQuat(real.Conjugate(), dual.Conjugate());
+}
+
+DualQuat operator+(const DualQuat& a, const DualQuat& b)
+{
+    return DualQuat(a.real + b.real, a.dual + b.dual);
+}
+
+DualQuat operator*(const DualQuat& dq, float f)
+{
+    return DualQuat(dq.real * f, dq.dual * f);
+}
+
+DualQuat operator*(const DualQuat& a, const DualQuat& b)
+{
+    return DualQuat(a.real * b.real, a.real * b.dual + a.dual * b.real);
+}
+
+bool operator==(const DualQuat& a, const DualQuat& b)
+{
+    return a.real == b.real && a.dual == b.dual;
+}
+
+bool operator!=(const DualQuat& a, const DualQuat& b)
+{
+    return !(a == b);
+}
@@ -0,0 +1,72 @@
+#include "Math/Public/Mat3x4.h"
+#include <cmath>
+
+bool operator==(const Mat3x4& a, const Mat3x4& b)
+{
+    for (int i = 0; i < 12; ++i)
+    {
+        if (fabsf(a.v[i] - b.v[i]) > MAT3X4_EPSILON)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool operator!=(const Mat3x4& a, const Mat3x4& b)
+{
+    return !(a == b);
+}
+
+// Same as the Mat4 product, with the implicit bottom row of b only adding a's translation
+#define M34D(aRow, bCol) \
+    a.v[aRow * 4 + 0] * b.v[0 * 4 + bCol] + \
+    a.v[aRow * 4 + 1] * b.v[1 * 4 + bCol] + \
+    a.v[aRow * 4 + 2] * b.v[2 * 4 + bCol]
+
+Mat3x4 operator*(const Mat3x4& a, const Mat3x4& b)
+{
+    Mat3x4 result;
+    for (int row = 0; row < 3; ++row)
+    {
+        result.v[row * 4 + 0] = M34D(row, 0);
+        result.v[row * 4 + 1] = M34D(row, 1);
+        result.v[row * 4 + 2] = M34D(row, 2);
+        result.v[row * 4 + 3] = M34D(row, 3) + a.v[row * 4 + 3];
+    }
+    return result;
+}
+
+#define M34V3D(mRow, x, y, z, w) \
+    x * m.v[mRow * 4 + 0] + \
+    y * m.v[mRow * 4 + 1] + \
+    z * m.v[mRow * 4 + 2] + \
+    w * m.v[mRow * 4 + 3]
+
+Vec3 Mat3x4::TransformVector(const Mat3x4& m, const Vec3& v)
+{
+    return Vec3(
+        M34V3D(0, v.x, v.y, v.z, 0.0f),
+        M34V3D(1, v.x, v.y, v.z, 0.0f),
+        M34V3D(2, v.x, v.y, v.z, 0.0f)
+    );
+}
+
+Vec3 Mat3x4::TransformPoint(const Mat3x4& m, const Vec3& v)
+{
+    return Vec3(
+        M34V3D(0, v.x, v.y, v.z, 1.0f),
+        M34V3D(1, v.x, v.y, v.z, 1.0f),
+        M34V3D(2, v.x, v.y, v.z, 1.0f)
+    );
+}
+
+Mat4 Mat3x4::ToMat4() const
+{
+    return Mat4(
+        r0c0, r1c0, r2c0, 0.0f,
+        r0c1, r1c1, r2c1, 0.0f,
+        r0c2, r1c2, r2c2, 0.0f,
+        r0c3, r1c3, r2c3, 1.0f
+    );
+}
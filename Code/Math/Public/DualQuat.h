@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Math/Public/Vec3.h"
+#include "Math/Public/Quat.h"
+#include "Math/Public/Transform.h"
+
+// Rigid transform as a dual quaternion: real is the rotation, dual is half the translation
+// times the rotation. Scale can't be represented and is dropped on conversion.
+// Multiplication follows Quat, a * b applies a first and then b.
+struct DualQuat
+{
+    Quat real;
+    Quat dual;
+
+    DualQuat() :
+        real(0, 0, 0, 1), dual(0, 0, 0, 0)
+    {
+    }
+
+    DualQuat(const Quat& r, const Quat& d) :
+        real(r), dual(d)
+    {
+    }
+
+    static DualQuat FromTransform(const Transform& t);
+    static float Dot(const DualQuat& a, const DualQuat& b);
+
+    Transform ToTransform() const;
+    Vec3 GetTranslation() const;
+    Vec3 TransformPoint(const Vec3& v) const;
+    Vec3 TransformVector(const Vec3& v) const;
+    void Normalize();
+    DualQuat Normalized() const;
+    DualQuat Conjugate() const;
+};
+
+DualQuat operator+(const DualQuat& a, const DualQuat& b);
+DualQuat operator*(const DualQuat& dq, float f);
+DualQuat operator*(const DualQuat& a, const DualQuat& b);
+bool operator==(const DualQuat& a, const DualQuat& b);
+bool operator!=(const DualQuat& a, const DualQuat& b);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Math/Public/Vec3.h"
+#include "Math/Public/Mat4.h"
+
+#define MAT3X4_EPSILON 0.000001f
+
+// Affine matrix without the constant (0, 0, 0, 1) row of a Mat4, stored row major so each
+// row is one vec4 in a shader: the first three columns are rotation and scale, the last translation
+struct Mat3x4
+{
+    union
+    {
+        float v[12];
+
+        struct
+        {
+            /* row 1 */
+            float r0c0;
+            float r0c1;
+            float r0c2;
+            float r0c3;
+            /* row 2 */
+            float r1c0;
+            float r1c1;
+            float r1c2;
+            float r1c3;
+            /* row 3 */
+            float r2c0;
+            float r2c1;
+            float r2c2;
+            float r2c3;
+        };
+    };
+
+    Mat3x4() :
+        r0c0(1), r0c1(0), r0c2(0), r0c3(0),
+        r1c0(0), r1c1(1), r1c2(0), r1c3(0),
+        r2c0(0), r2c1(0), r2c2(1), r2c3(0)
+    {
+    }
+
+    // Drops the bottom row, which has to be (0, 0, 0, 1)
+    explicit Mat3x4(const Mat4& m) :
+        r0c0(m.r0c0), r0c1(m.r0c1), r0c2(m.r0c2), r0c3(m.r0c3),
+        r1c0(m.r1c0), r1c1(m.r1c1), r1c2(m.r1c2), r1c3(m.r1c3),
+        r2c0(m.r2c0), r2c1(m.r2c1), r2c2(m.r2c2), r2c3(m.r2c3)
+    {
+    }
+
+    static Vec3 TransformVector(const Mat3x4& m, const Vec3& v);
+    static Vec3 TransformPoint(const Mat3x4& m, const Vec3& v);
+
+    Mat4 ToMat4() const;
+};
+
+bool operator==(const Mat3x4& a, const Mat3x4& b);
+bool operator!=(const Mat3x4& a, const Mat3x4& b);
+Mat3x4 operator*(const Mat3x4& a, const Mat3x4& b);
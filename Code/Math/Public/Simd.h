@@ -0,0 +1,9 @@
+#pragma once
+
+// SSE2 is part of every x64 target, and of x86 builds with /arch:SSE2 or newer
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_SSE 1
+#include <emmintrin.h>
+#else
+#define MATH_SSE 0
+#endif
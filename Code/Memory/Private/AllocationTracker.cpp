@@ -0,0 +1,268 @@
+#include "Memory/Public/AllocationTracker.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+namespace AllocationTrackerHelpers
+{
+    // Plain globals, they are constant initialized before any operator new can run
+    std::atomic<unsigned int> gFrameAllocations(0);
+    std::atomic<unsigned int> gFrameFrees(0);
+    std::atomic<unsigned long long> gFrameBytes(0);
+    std::atomic<unsigned int> gTotalAllocations(0);
+    std::atomic<unsigned int> gTotalFrees(0);
+    std::atomic<unsigned long long> gTotalBytes(0);
+    std::atomic<bool> gInFrame(false);
+    std::atomic<bool> gFailOnFrameAllocation(false);
+
+    inline void RecordAllocation(std::size_t size)
+    {
+        ++gTotalAllocations;
+        gTotalBytes += size;
+        if (gInFrame.load(std::memory_order_relaxed))
+        {
+            ++gFrameAllocations;
+            gFrameBytes += size;
+            if (gFailOnFrameAllocation.load(std::memory_order_relaxed))
+            {
+                // Anything fancier than fputs could allocate again
+                fputs("Heap allocation inside an allocation free frame\n", stderr);
+                abort();
+            }
+        }
+    }
+
+    inline void RecordFree(void* ptr)
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        ++gTotalFrees;
+        if (gInFrame.load(std::memory_order_relaxed))
+        {
+            ++gFrameFrees;
+        }
+    }
+
+    inline void* Allocate(std::size_t size)
+    {
+        RecordAllocation(size);
+        return malloc(size == 0 ? 1 : size);
+    }
+
+    inline void Free(void* ptr)
+    {
+        RecordFree(ptr);
+        free(ptr);
+    }
+
+#ifdef __cpp_aligned_new
+    // Over aligned blocks can't go through free, they need the matching aligned release
+    inline void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+    {
+        RecordAllocation(size);
+        const std::size_t align = static_cast<std::size_t>(alignment);
+        if (size == 0)
+        {
+            size = 1;
+        }
+#ifdef _MSC_VER
+        return _aligned_malloc(size, align);
+#else
+        void* ptr = nullptr;
+        return posix_memalign(&ptr, align, size) == 0 ? ptr : nullptr;
+#endif
+    }
+
+    inline void FreeAligned(void* ptr)
+    {
+        RecordFree(ptr);
+#ifdef _MSC_VER
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+#endif
+} // End of AllocationTrackerHelpers
+
+void BeginAllocationFrame()
+{
+    using namespace AllocationTrackerHelpers;
+    gFrameAllocations = 0;
+    gFrameFrees = 0;
+    gFrameBytes = 0;
+    gInFrame = true;
+}
+
+AllocationStats EndAllocationFrame()
+{
+    AllocationTrackerHelpers::gInFrame = false;
+    return GetFrameAllocationStats();
+}
+
+AllocationStats GetFrameAllocationStats()
+{
+    using namespace AllocationTrackerHelpers;
+    AllocationStats stats;
+    stats.mAllocations = gFrameAllocations;
+    stats.mFrees = gFrameFrees;
+    stats.mBytes = gFrameBytes;
+    return stats;
+}
+
+AllocationStats GetTotalAllocationStats()
+{
+    using namespace AllocationTrackerHelpers;
+    AllocationStats stats;
+    stats.mAllocations = gTotalAllocations;
+    stats.mFrees = gTotalFrees;
+    stats.mBytes = gTotalBytes;
+    return stats;
+}
+
+void SetFailOnFrameAllocation(bool fail)
+{
+    AllocationTrackerHelpers::gFailOnFrameAllocation = fail;
+}
+
+bool ExpectNoFrameAllocations(const AllocationStats& frame, const char* label)
+{
+    if (frame.mAllocations == 0)
+    {
+        return true;
+    }
+    std::cout << label << ": " << frame.mAllocations << " allocations (" << frame.mBytes
+        << " bytes), " << frame.mFrees << " frees\n";
+    return false;
+}
+
+#if ALLOCATION_TRACKER
+void* operator new(std::size_t size)
+{
+    void* ptr = AllocationTrackerHelpers::Allocate(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* ptr = AllocationTrackerHelpers::Allocate(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return AllocationTrackerHelpers::Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return AllocationTrackerHelpers::Allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    AllocationTrackerHelpers::Free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    AllocationTrackerHelpers::Free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    AllocationTrackerHelpers::Free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    AllocationTrackerHelpers::Free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    AllocationTrackerHelpers::Free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    AllocationTrackerHelpers::Free(ptr);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void* ptr = AllocationTrackerHelpers::AllocateAligned(size, alignment);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    void* ptr = AllocationTrackerHelpers::AllocateAligned(size, alignment);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocationTrackerHelpers::AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocationTrackerHelpers::AllocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+    AllocationTrackerHelpers::FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+    AllocationTrackerHelpers::FreeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    AllocationTrackerHelpers::FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    AllocationTrackerHelpers::FreeAligned(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    AllocationTrackerHelpers::FreeAligned(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+    AllocationTrackerHelpers::FreeAligned(ptr);
+}
+#endif
+#endif
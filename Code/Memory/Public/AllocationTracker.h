@@ -0,0 +1,39 @@
+#pragma once
+
+// Counts heap allocations by replacing the global operator new and delete. Every allocation
+// pays for a few atomics, so only debug builds hook them unless ALLOCATION_TRACKER is set to 1.
+#ifndef ALLOCATION_TRACKER
+#ifdef _DEBUG
+#define ALLOCATION_TRACKER 1
+#else
+#define ALLOCATION_TRACKER 0
+#endif
+#endif
+
+// Frames before this one may still be growing their scratch buffers
+#define ALLOCATION_TRACKER_WARMUP_FRAMES 3
+
+struct AllocationStats
+{
+    unsigned int mAllocations;
+    unsigned int mFrees;
+    unsigned long long mBytes;
+
+    AllocationStats() : mAllocations(0), mFrees(0), mBytes(0)
+    {
+    }
+};
+
+// Allocations from any thread between BeginAllocationFrame and EndAllocationFrame count
+// towards the frame. Steady state frames are expected to allocate nothing.
+void BeginAllocationFrame();
+AllocationStats EndAllocationFrame();
+AllocationStats GetFrameAllocationStats();
+AllocationStats GetTotalAllocationStats();
+
+// Aborts on the first allocation inside a frame, so a test fails with the offending call
+// on the stack. Only enable it once the warm up frames are done.
+void SetFailOnFrameAllocation(bool fail);
+
+// Prints the frame's counts to std::cout and returns false when the frame allocated
+bool ExpectNoFrameAllocations(const AllocationStats& frame, const char* label);
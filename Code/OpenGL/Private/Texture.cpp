@@ -1,6 +1,68 @@
 #include "OpenGL/Public/Texture.h"
 #include "OpenGL/Public/stb_image.h"
 #include "Window/Public/glad.h"
+#include <iostream>
+
+TextureImage::TextureImage()
+{
+    mPixels = nullptr;
+    mWidth = 0;
+    mHeight = 0;
+    mChannels = 0;
+}
+
+TextureImage::~TextureImage()
+{
+    Free();
+}
+
+bool TextureImage::Decode(const char* path)
+{
+    Free();
+    int width, height, channels;
+    mPixels = stbi_load(path, &width, &height, &channels, 4);
+    if (mPixels == nullptr)
+    {
+        std::cout << "Could not decode image: " << path << "\n";
+        return false;
+    }
+    mWidth = width;
+    mHeight = height;
+    mChannels = channels;
+    return true;
+}
+
+void TextureImage::Free()
+{
+    if (mPixels != nullptr)
+    {
+        stbi_image_free(mPixels);
+    }
+    mPixels = nullptr;
+    mWidth = 0;
+    mHeight = 0;
+    mChannels = 0;
+}
+
+const unsigned char* TextureImage::GetPixels() const
+{
+    return mPixels;
+}
+
+unsigned int TextureImage::GetWidth() const
+{
+    return mWidth;
+}
+
+unsigned int TextureImage::GetHeight() const
+{
+    return mHeight;
+}
+
+unsigned int TextureImage::GetChannels() const
+{
+    return mChannels;
+}
 
 Texture::Texture()
 {
@@ -23,14 +85,19 @@ Texture::~Texture()
 
 
 void Texture::Load(const char* path)
+{
+    TextureImage image;
+    image.Decode(path);
+    Load(image);
+}
+
+void Texture::Load(const TextureImage& image)
 {
     glBindTexture(GL_TEXTURE_2D, mHandle);
 
-    int width, height, channels;
-    unsigned char* data = stbi_load(path, &width, &height, &channels, 4);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.GetWidth(), image.GetHeight(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 image.GetPixels());
     glGenerateMipmap(GL_TEXTURE_2D);
-    stbi_image_free(data);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -40,9 +107,9 @@ void Texture::Load(const char* path)
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    mWidth = width;
-    mHeight = height;
-    mChannels = channels;
+    mWidth = image.GetWidth();
+    mHeight = image.GetHeight();
+    mChannels = image.GetChannels();
 }
 
 void Texture::Set(unsigned int uniformIndex, unsigned int textureIndex)
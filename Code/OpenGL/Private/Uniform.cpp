@@ -5,6 +5,8 @@
 #include "Math/Public/Vec4.h"
 #include "Math/Public/Quat.h"
 #include "Math/Public/Mat4.h"
+#include "Math/Public/DualQuat.h"
+#include "Math/Public/Mat3x4.h"
 
 template Uniform<int>;
 template Uniform<IVec4>;
@@ -15,6 +17,8 @@ template Uniform<Vec3>;
 template Uniform<Vec4>;
 template Uniform<Quat>;
 template Uniform<Mat4>;
+template Uniform<DualQuat>;
+template Uniform<Mat3x4>;
 
 #define UNIFORM_IMPL(gl_func, tType, dType) \
 template<> \
@@ -37,6 +41,20 @@ void Uniform<Mat4>::Set(unsigned int slot, Mat4* inputArray, unsigned int arrayL
     glUniformMatrix4fv(slot, static_cast<GLsizei>(arrayLength), false, (float*)&inputArray[0]);
 }
 
+// A mat2x4 per dual quaternion, the real part is the first column
+template <>
+void Uniform<DualQuat>::Set(unsigned int slot, DualQuat* inputArray, unsigned int arrayLength)
+{
+    glUniformMatrix2x4fv(slot, static_cast<GLsizei>(arrayLength), false, inputArray[0].real.v);
+}
+
+// Three vec4 rows per matrix, so the shader array is three times the joint count
+template <>
+void Uniform<Mat3x4>::Set(unsigned int slot, Mat3x4* inputArray, unsigned int arrayLength)
+{
+    glUniform4fv(slot, static_cast<GLsizei>(arrayLength * 3), inputArray[0].v);
+}
+
 template <typename T>
 void Uniform<T>::Set(unsigned int slot, const T& value)
 {
@@ -1,5 +1,32 @@
 #pragma once
 
+// RGBA pixels decoded from an image file. Decoding touches no GL state, so it can run on any
+// thread, Texture::Load uploads the result on the thread that owns the context.
+class TextureImage
+{
+protected:
+    unsigned char* mPixels;
+    unsigned int mWidth;
+    unsigned int mHeight;
+    unsigned int mChannels;
+private:
+    TextureImage(const TextureImage& other);
+    TextureImage& operator=(const TextureImage& other);
+public:
+    TextureImage();
+    ~TextureImage();
+
+    // Returns false and leaves the image empty when the file can't be decoded
+    bool Decode(const char* path);
+    void Free();
+
+    const unsigned char* GetPixels() const;
+    unsigned int GetWidth() const;
+    unsigned int GetHeight() const;
+    // Channels in the file, the pixels always have four
+    unsigned int GetChannels() const;
+};
+
 class Texture
 {
 protected:
@@ -16,6 +43,7 @@ public:
     ~Texture();
 
     void Load(const char* path);
+    void Load(const TextureImage& image);
 
     void Set(unsigned int uniformIndex, unsigned int textureIndex);
     void UnSet(unsigned int textureIndex);
@@ -2,24 +2,72 @@
 #include "OpenGL/Public/Draw.h"
 #include "Math/Public/Transform.h"
 
+namespace MeshHelpers
+{
+    struct SkinContext
+    {
+        Mesh* mMesh;
+        const Mat4* mSkinPalette;
+    };
+
+    struct SkinDualQuatContext
+    {
+        Mesh* mMesh;
+        const DualQuat* mSkinPalette;
+    };
+
+    struct SkinBatchContext
+    {
+        const SkinJob* mJobs;
+        unsigned int mCount;
+    };
+
+    inline unsigned int NumSkinChunks(unsigned int numVerts)
+    {
+        return (numVerts + MESH_SKIN_CHUNK - 1) / MESH_SKIN_CHUNK;
+    }
+
+    inline float RealDot(const DualQuat& a, const DualQuat& b)
+    {
+        return a.real.x * b.real.x + a.real.y * b.real.y + a.real.z * b.real.z + a.real.w * b.real.w;
+    }
+
+#if MESH_SKIN_SSE
+    inline void StoreVec3(Vec3& out, __m128 value)
+    {
+        // Exactly three floats, a four float store would reach into the next vertex
+        _mm_storel_pi(reinterpret_cast<__m64*>(out.v), value);
+        _mm_store_ss(out.v + 2, _mm_movehl_ps(value, value));
+    }
+
+    // Dot product of two four float vectors, in every lane
+    inline __m128 Dot4(__m128 a, __m128 b)
+    {
+        __m128 products = _mm_mul_ps(a, b);
+        products = _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(products, _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+#endif
+} // End of MeshHelpers
+
 Mesh::Mesh()
 {
-    mPosAttrib = new Attribute<Vec3>();
-    mNormAttrib = new Attribute<Vec3>();
-    mUvAttrib = new Attribute<Vec2>();
-    mWeightAttrib = new Attribute<Vec4>();
-    mInfluenceAttrib = new Attribute<IVec4>();
-    mIndexBuffer = new IndexBuffer();
+    mPosAttrib = nullptr;
+    mNormAttrib = nullptr;
+    mUvAttrib = nullptr;
+    mWeightAttrib = nullptr;
+    mInfluenceAttrib = nullptr;
+    mIndexBuffer = nullptr;
 }
 
 Mesh::Mesh(const Mesh& other)
 {
-    mPosAttrib = new Attribute<Vec3>();
-    mNormAttrib = new Attribute<Vec3>();
-    mUvAttrib = new Attribute<Vec2>();
-    mWeightAttrib = new Attribute<Vec4>();
-    mInfluenceAttrib = new Attribute<IVec4>();
-    mIndexBuffer = new IndexBuffer();
+    mPosAttrib = nullptr;
+    mNormAttrib = nullptr;
+    mUvAttrib = nullptr;
+    mWeightAttrib = nullptr;
+    mInfluenceAttrib = nullptr;
+    mIndexBuffer = nullptr;
     *this = other;
 }
 
@@ -35,7 +83,12 @@ Mesh& Mesh::operator=(const Mesh& other)
     mWeights = other.mWeights;
     mInfluences = other.mInfluences;
     mIndices = other.mIndices;
-    UpdateOpenGLBuffers();
+    mSkinJoints = other.mSkinJoints;
+    // Copies of a mesh that was never uploaded stay off the GPU, they may live on a loading thread
+    if (other.HasOpenGLBuffers() || HasOpenGLBuffers())
+    {
+        UpdateOpenGLBuffers();
+    }
     return *this;
 }
 
@@ -79,8 +132,33 @@ std::vector<unsigned int>& Mesh::GetIndices()
     return mIndices;
 }
 
+std::vector<unsigned int>& Mesh::GetSkinJoints()
+{
+    return mSkinJoints;
+}
+
+bool Mesh::HasOpenGLBuffers() const
+{
+    return mPosAttrib != nullptr;
+}
+
+void Mesh::CreateOpenGLBuffers()
+{
+    if (mPosAttrib != nullptr)
+    {
+        return;
+    }
+    mPosAttrib = new Attribute<Vec3>();
+    mNormAttrib = new Attribute<Vec3>();
+    mUvAttrib = new Attribute<Vec2>();
+    mWeightAttrib = new Attribute<Vec4>();
+    mInfluenceAttrib = new Attribute<IVec4>();
+    mIndexBuffer = new IndexBuffer();
+}
+
 void Mesh::UpdateOpenGLBuffers()
 {
+    CreateOpenGLBuffers();
     if (mPosition.size() > 0)
     {
         mPosAttrib->Set(mPosition);
@@ -109,6 +187,7 @@ void Mesh::UpdateOpenGLBuffers()
 
 void Mesh::Bind(int position, int normal, int texCoord, int weight, int influcence)
 {
+    CreateOpenGLBuffers();
     if (position >= 0)
     {
         mPosAttrib->BindTo(position);
@@ -157,6 +236,10 @@ void Mesh::DrawInstanced(unsigned int numInstances)
 
 void Mesh::UnBind(int position, int normal, int texCoord, int weight, int influcence)
 {
+    if (!HasOpenGLBuffers())
+    {
+        return;
+    }
     if (position >= 0)
     {
         mPosAttrib->UnBindFrom(position);
@@ -181,32 +264,297 @@ void Mesh::UnBind(int position, int normal, int texCoord, int weight, int influc
 
 #if 1
 void Mesh::CPUSkin(Skeleton& skeleton, Pose& pose)
+{
+    if (mPosition.empty()) { return; }
+
+    if (mSkinJoints.empty())
+    {
+        skeleton.GetSkinPalette(pose, mSkinPalette);
+    }
+    else
+    {
+        skeleton.GetSkinPalette(pose, mSkinJoints, mSkinPalette);
+    }
+    CPUSkin(mSkinPalette);
+}
+
+void Mesh::CPUSkin(const std::vector<Mat4>& skinPalette)
+{
+    unsigned int numVerts = static_cast<unsigned>(mPosition.size());
+    if (numVerts == 0) { return; }
+
+    PrepareSkin();
+    SkinRange(&skinPalette[0], 0, numVerts);
+    UploadSkin();
+}
+
+void Mesh::CPUSkin(const std::vector<DualQuat>& skinPalette)
+{
+    unsigned int numVerts = static_cast<unsigned>(mPosition.size());
+    if (numVerts == 0) { return; }
+
+    PrepareSkin();
+    SkinRangeDualQuat(&skinPalette[0], 0, numVerts);
+    UploadSkin();
+}
+
+void Mesh::CPUSkin(const std::vector<DualQuat>& skinPalette, WorkerPool& pool)
+{
+    unsigned int numVerts = static_cast<unsigned>(mPosition.size());
+    if (numVerts == 0) { return; }
+
+    PrepareSkin();
+    MeshHelpers::SkinDualQuatContext context = { this, &skinPalette[0] };
+    pool.ParallelFor(numVerts, MESH_SKIN_CHUNK, &Mesh::SkinDualQuatChunk, &context);
+    UploadSkin();
+}
+
+void Mesh::CPUSkinReference(const std::vector<Mat4>& skinPalette)
 {
     unsigned int numVerts = static_cast<unsigned>(mPosition.size());
     if (numVerts == 0) { return; }
 
+    PrepareSkin();
+    SkinRangeReference(&skinPalette[0], 0, numVerts);
+    UploadSkin();
+}
+
+void Mesh::CPUSkin(const std::vector<Mat4>& skinPalette, WorkerPool& pool)
+{
+    unsigned int numVerts = static_cast<unsigned>(mPosition.size());
+    if (numVerts == 0) { return; }
+
+    PrepareSkin();
+    MeshHelpers::SkinContext context = { this, &skinPalette[0] };
+    pool.ParallelFor(numVerts, MESH_SKIN_CHUNK, &Mesh::SkinChunk, &context);
+    UploadSkin();
+}
+
+void Mesh::CPUSkinBatch(SkinJob* jobs, unsigned int count, WorkerPool& pool)
+{
+    // Chunks of every mesh are numbered one after the other, so small meshes don't leave the
+    // pool idle. The jobs hold the running chunk count, each chunk binary searches them for its
+    // mesh and nothing is allocated.
+    unsigned int numChunks = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        jobs[i].mMesh->PrepareSkin();
+        jobs[i].mFirstChunk = numChunks;
+        numChunks += MeshHelpers::NumSkinChunks(static_cast<unsigned>(jobs[i].mMesh->mPosition.size()));
+    }
+
+    MeshHelpers::SkinBatchContext context = { jobs, count };
+    pool.ParallelFor(numChunks, 1, &Mesh::SkinBatchChunk, &context);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (!jobs[i].mMesh->mPosition.empty())
+        {
+            jobs[i].mMesh->UploadSkin();
+        }
+    }
+}
+
+void Mesh::SkinChunk(void* context, unsigned int begin, unsigned int end)
+{
+    MeshHelpers::SkinContext* skin = static_cast<MeshHelpers::SkinContext*>(context);
+    skin->mMesh->SkinRange(skin->mSkinPalette, begin, end);
+}
+
+void Mesh::SkinDualQuatChunk(void* context, unsigned int begin, unsigned int end)
+{
+    MeshHelpers::SkinDualQuatContext* skin = static_cast<MeshHelpers::SkinDualQuatContext*>(context);
+    skin->mMesh->SkinRangeDualQuat(skin->mSkinPalette, begin, end);
+}
+
+void Mesh::SkinBatchChunk(void* context, unsigned int begin, unsigned int end)
+{
+    MeshHelpers::SkinBatchContext* batch = static_cast<MeshHelpers::SkinBatchContext*>(context);
+    // Last job whose first chunk is not after begin, empty meshes share their first chunk with the next job
+    unsigned int low = 0;
+    unsigned int high = batch->mCount - 1;
+    while (low < high)
+    {
+        const unsigned int middle = (low + high + 1) / 2;
+        if (batch->mJobs[middle].mFirstChunk <= begin)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    unsigned int job = low;
+    for (unsigned int chunk = begin; chunk < end; ++chunk)
+    {
+        while (job + 1 < batch->mCount && chunk >= batch->mJobs[job + 1].mFirstChunk)
+        {
+            ++job;
+        }
+
+        const unsigned int numVerts = static_cast<unsigned>(batch->mJobs[job].mMesh->mPosition.size());
+        const unsigned int vertBegin = (chunk - batch->mJobs[job].mFirstChunk) * MESH_SKIN_CHUNK;
+        const unsigned int vertEnd = numVerts - vertBegin < MESH_SKIN_CHUNK ? numVerts : vertBegin + MESH_SKIN_CHUNK;
+        batch->mJobs[job].mMesh->SkinRange(&(*batch->mJobs[job].mSkinPalette)[0], vertBegin, vertEnd);
+    }
+}
+
+void Mesh::PrepareSkin()
+{
+    unsigned int numVerts = static_cast<unsigned>(mPosition.size());
     mSkinnedPosition.resize(numVerts);
     mSkinnedNormal.resize(numVerts);
+}
+
+// Each vertex only writes its own output, so any split of the range gives the same result.
+// The SSE path does the same sums in the same order as the reference, one Mat4 column per
+// register, and stops at the affine part: no projective row is read back and nothing divides by w.
+void Mesh::SkinRange(const Mat4* skinPalette, unsigned int begin, unsigned int end)
+{
+#if MESH_SKIN_SSE
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        const IVec4& j = mInfluences[i];
+        const Vec4& w = mWeights[i];
+        const float* m0 = skinPalette[j.x].v;
+        const float* m1 = skinPalette[j.y].v;
+        const float* m2 = skinPalette[j.z].v;
+        const float* m3 = skinPalette[j.w].v;
+        const __m128 w0 = _mm_set1_ps(w.x);
+        const __m128 w1 = _mm_set1_ps(w.y);
+        const __m128 w2 = _mm_set1_ps(w.z);
+        const __m128 w3 = _mm_set1_ps(w.w);
+
+        __m128 columns[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            __m128 column = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m0 + c * 4), w0),
+                                       _mm_mul_ps(_mm_loadu_ps(m1 + c * 4), w1));
+            column = _mm_add_ps(column, _mm_mul_ps(_mm_loadu_ps(m2 + c * 4), w2));
+            columns[c] = _mm_add_ps(column, _mm_mul_ps(_mm_loadu_ps(m3 + c * 4), w3));
+        }
 
-    pose.GetMatrixPalette(mPosePalette);
-    std::vector<Mat4> invPosePalette = skeleton.GetInvBindPose();
+        const Vec3& p = mPosition[i];
+        __m128 position = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), columns[0]),
+                                     _mm_mul_ps(_mm_set1_ps(p.y), columns[1]));
+        position = _mm_add_ps(position, _mm_mul_ps(_mm_set1_ps(p.z), columns[2]));
+        position = _mm_add_ps(position, columns[3]);
+        MeshHelpers::StoreVec3(mSkinnedPosition[i], position);
 
-    for (unsigned int i = 0; i < numVerts; ++i)
+        const Vec3& n = mNormal[i];
+        __m128 normal = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n.x), columns[0]),
+                                   _mm_mul_ps(_mm_set1_ps(n.y), columns[1]));
+        normal = _mm_add_ps(normal, _mm_mul_ps(_mm_set1_ps(n.z), columns[2]));
+        MeshHelpers::StoreVec3(mSkinnedNormal[i], normal);
+    }
+#else
+    SkinRangeReference(skinPalette, begin, end);
+#endif
+}
+
+void Mesh::SkinRangeReference(const Mat4* skinPalette, unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; ++i)
     {
         IVec4& j = mInfluences[i];
         Vec4& w = mWeights[i];
 
-        Mat4 m0 = (mPosePalette[j.x] * invPosePalette[j.x]) * w.x;
-        Mat4 m1 = (mPosePalette[j.y] * invPosePalette[j.y]) * w.y;
-        Mat4 m2 = (mPosePalette[j.z] * invPosePalette[j.z]) * w.z;
-        Mat4 m3 = (mPosePalette[j.w] * invPosePalette[j.w]) * w.w;
+        Mat4 m0 = skinPalette[j.x] * w.x;
+        Mat4 m1 = skinPalette[j.y] * w.y;
+        Mat4 m2 = skinPalette[j.z] * w.z;
+        Mat4 m3 = skinPalette[j.w] * w.w;
 
         Mat4 skin = m0 + m1 + m2 + m3;
 
         mSkinnedPosition[i] = Mat4::TransformPoint(skin, mPosition[i]);
         mSkinnedNormal[i] = Mat4::TransformVector(skin, mNormal[i]);
     }
+}
 
+// Blends the four dual quaternions, then applies the result without normalizing it: rotation
+// and translation are both quadratic in the blend, so one divide by its squared length does.
+void Mesh::SkinRangeDualQuat(const DualQuat* skinPalette, unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        const IVec4& j = mInfluences[i];
+        const Vec4& w = mWeights[i];
+        const DualQuat& d0 = skinPalette[j.x];
+        const DualQuat& d1 = skinPalette[j.y];
+        const DualQuat& d2 = skinPalette[j.z];
+        const DualQuat& d3 = skinPalette[j.w];
+
+        // Influences in the other hemisphere would blend the long way around, so their weight
+        // takes the sign of their dot product with the first one
+        float r[4];
+        float d[4];
+#if MESH_SKIN_SSE
+        const __m128 real0 = _mm_loadu_ps(d0.real.v);
+        const __m128 real1 = _mm_loadu_ps(d1.real.v);
+        const __m128 real2 = _mm_loadu_ps(d2.real.v);
+        const __m128 real3 = _mm_loadu_ps(d3.real.v);
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 w0 = _mm_set1_ps(w.x);
+        const __m128 w1 = _mm_xor_ps(_mm_set1_ps(w.y), _mm_and_ps(MeshHelpers::Dot4(real0, real1), signBit));
+        const __m128 w2 = _mm_xor_ps(_mm_set1_ps(w.z), _mm_and_ps(MeshHelpers::Dot4(real0, real2), signBit));
+        const __m128 w3 = _mm_xor_ps(_mm_set1_ps(w.w), _mm_and_ps(MeshHelpers::Dot4(real0, real3), signBit));
+
+        __m128 real = _mm_mul_ps(real0, w0);
+        __m128 dual = _mm_mul_ps(_mm_loadu_ps(d0.dual.v), w0);
+        real = _mm_add_ps(real, _mm_mul_ps(real1, w1));
+        dual = _mm_add_ps(dual, _mm_mul_ps(_mm_loadu_ps(d1.dual.v), w1));
+        real = _mm_add_ps(real, _mm_mul_ps(real2, w2));
+        dual = _mm_add_ps(dual, _mm_mul_ps(_mm_loadu_ps(d2.dual.v), w2));
+        real = _mm_add_ps(real, _mm_mul_ps(real3, w3));
+        dual = _mm_add_ps(dual, _mm_mul_ps(_mm_loadu_ps(d3.dual.v), w3));
+        _mm_storeu_ps(r, real);
+        _mm_storeu_ps(d, dual);
+#else
+        const float w1 = MeshHelpers::RealDot(d0, d1) < 0.0f ? -w.y : w.y;
+        const float w2 = MeshHelpers::RealDot(d0, d2) < 0.0f ? -w.z : w.z;
+        const float w3 = MeshHelpers::RealDot(d0, d3) < 0.0f ? -w.w : w.w;
+        for (int c = 0; c < 4; ++c)
+        {
+            r[c] = d0.real.v[c] * w.x + d1.real.v[c] * w1 + d2.real.v[c] * w2 + d3.real.v[c] * w3;
+            d[c] = d0.dual.v[c] * w.x + d1.dual.v[c] * w1 + d2.dual.v[c] * w2 + d3.dual.v[c] * w3;
+        }
+#endif
+
+        const float lenSq = r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3];
+        const float invLenSq = lenSq < QUAT_EPSILON ? 0.0f : 1.0f / lenSq;
+
+        // Rotation by the unnormalized quaternion as a 3x3 matrix, scaled by its squared length.
+        // Written out in floats, the Vec3 and Quat operators aren't inlined across files.
+        const float xx = r[0] * r[0], yy = r[1] * r[1], zz = r[2] * r[2], ww = r[3] * r[3];
+        const float xy = r[0] * r[1], xz = r[0] * r[2], yz = r[1] * r[2];
+        const float wx = r[3] * r[0], wy = r[3] * r[1], wz = r[3] * r[2];
+        const float m00 = ww + xx - yy - zz, m01 = 2.0f * (xy - wz), m02 = 2.0f * (xz + wy);
+        const float m10 = 2.0f * (xy + wz), m11 = ww - xx + yy - zz, m12 = 2.0f * (yz - wx);
+        const float m20 = 2.0f * (xz - wy), m21 = 2.0f * (yz + wx), m22 = ww - xx - yy + zz;
+
+        // Translation is twice the vector part of dual * conjugate(real)
+        const float tx = 2.0f * (d[0] * r[3] - r[0] * d[3] + r[1] * d[2] - r[2] * d[1]);
+        const float ty = 2.0f * (d[1] * r[3] - r[1] * d[3] + r[2] * d[0] - r[0] * d[2]);
+        const float tz = 2.0f * (d[2] * r[3] - r[2] * d[3] + r[0] * d[1] - r[1] * d[0]);
+
+        const Vec3& p = mPosition[i];
+        const Vec3& n = mNormal[i];
+        Vec3& outP = mSkinnedPosition[i];
+        Vec3& outN = mSkinnedNormal[i];
+        outP.x = (m00 * p.x + m01 * p.y + m02 * p.z + tx) * invLenSq;
+        outP.y = (m10 * p.x + m11 * p.y + m12 * p.z + ty) * invLenSq;
+        outP.z = (m20 * p.x + m21 * p.y + m22 * p.z + tz) * invLenSq;
+        outN.x = (m00 * n.x + m01 * n.y + m02 * n.z) * invLenSq;
+        outN.y = (m10 * n.x + m11 * n.y + m12 * n.z) * invLenSq;
+        outN.z = (m20 * n.x + m21 * n.y + m22 * n.z) * invLenSq;
+    }
+}
+
+void Mesh::UploadSkin()
+{
+    CreateOpenGLBuffers();
     mPosAttrib->Set(mSkinnedPosition);
     mNormAttrib->Set(mSkinnedNormal);
 }
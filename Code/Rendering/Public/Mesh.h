@@ -4,11 +4,31 @@
 #include "Math/Public/Vec3.h"
 #include "Math/Public/Vec4.h"
 #include "Math/Public/Mat4.h"
+#include "Math/Public/DualQuat.h"
+#include "Math/Public/Simd.h"
 #include <vector>
 #include "OpenGL/Public/Attribute.h"
 #include "OpenGL/Public/IndexBuffer.h"
 #include "Animation/Public/Skeleton.h"
 #include "Animation/Public/Pose.h"
+#include "Threading/Public/WorkerPool.h"
+
+// Vertices per parallel skinning chunk, about 80KB of vertex data in and out
+#define MESH_SKIN_CHUNK 1024
+
+// Skinning sums palette columns in SSE registers when the target has it
+#define MESH_SKIN_SSE MATH_SSE
+
+class Mesh;
+
+// One mesh to skin in a batch, instances of the same mesh each need their own Mesh copy
+struct SkinJob
+{
+    Mesh* mMesh;
+    const std::vector<Mat4>* mSkinPalette;
+    // Written by CPUSkinBatch, the batch wide index of the mesh's first chunk
+    unsigned int mFirstChunk;
+};
 
 class Mesh
 {
@@ -19,6 +39,8 @@ protected:
     std::vector<Vec4> mWeights;
     std::vector<IVec4> mInfluences;
     std::vector<unsigned int> mIndices;
+    // Palette slot to pose joint. Influences index this table, empty when they index the pose.
+    std::vector<unsigned int> mSkinJoints;
 
     Attribute<Vec3>* mPosAttrib;
     Attribute<Vec3>* mNormAttrib;
@@ -29,7 +51,17 @@ protected:
 
     std::vector<Vec3> mSkinnedPosition;
     std::vector<Vec3> mSkinnedNormal;
-    std::vector<Mat4> mPosePalette;
+    std::vector<Mat4> mSkinPalette;
+
+    void CreateOpenGLBuffers();
+    void PrepareSkin();
+    void SkinRange(const Mat4* skinPalette, unsigned int begin, unsigned int end);
+    void SkinRangeReference(const Mat4* skinPalette, unsigned int begin, unsigned int end);
+    void SkinRangeDualQuat(const DualQuat* skinPalette, unsigned int begin, unsigned int end);
+    void UploadSkin();
+    static void SkinChunk(void* context, unsigned int begin, unsigned int end);
+    static void SkinDualQuatChunk(void* context, unsigned int begin, unsigned int end);
+    static void SkinBatchChunk(void* context, unsigned int begin, unsigned int end);
 public:
     Mesh();
     Mesh(const Mesh&);
@@ -41,8 +73,25 @@ public:
     std::vector<Vec4>& GetWeights();
     std::vector<IVec4>& GetInfluences();
     std::vector<unsigned int>& GetIndices();
+    std::vector<unsigned int>& GetSkinJoints();
     void CPUSkin(Skeleton& skeleton, Pose& pose);
+    // Skins with matrices from Skeleton::GetSkinPalette, meshes sharing a pose can share them
+    void CPUSkin(const std::vector<Mat4>& skinPalette);
+    // Same result as CPUSkin, with the vertices split into chunks over the pool.
+    // Only the skinning runs on the pool, buffers are uploaded on the calling thread.
+    void CPUSkin(const std::vector<Mat4>& skinPalette, WorkerPool& pool);
+    // Skins every job's mesh as one set of chunks over the pool, jobs are sorted by first chunk
+    static void CPUSkinBatch(SkinJob* jobs, unsigned int count, WorkerPool& pool);
+    // Dual quaternion skinning with transforms from Skeleton::GetDualQuatSkinPalette.
+    // Joints keep their volume when they twist, scale is ignored.
+    void CPUSkin(const std::vector<DualQuat>& skinPalette);
+    void CPUSkin(const std::vector<DualQuat>& skinPalette, WorkerPool& pool);
+    // Scalar Mat4 skinning the SSE kernel is checked against
+    void CPUSkinReference(const std::vector<Mat4>& skinPalette);
+    // GL buffers are created by the first upload or Bind, until then a mesh is plain CPU data
+    // and can be built on any thread. Uploading has to happen on the thread that owns the context.
     void UpdateOpenGLBuffers();
+    bool HasOpenGLBuffers() const;
     void Bind(int position, int normal, int texCoord, int weight, int influcence);
     void Draw();
     void DrawInstanced(unsigned int numInstances);
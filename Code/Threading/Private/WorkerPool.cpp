@@ -0,0 +1,124 @@
+#include "Threading/Public/WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int numThreads)
+{
+    mGeneration = 0;
+    mActiveWorkers = 0;
+    mQuit = false;
+    mFunction = nullptr;
+    mContext = nullptr;
+    mCount = 0;
+    mChunkSize = 0;
+    mNumChunks = 0;
+    mNextChunk = 0;
+
+    if (numThreads == 0)
+    {
+        const unsigned int hardware = std::thread::hardware_concurrency();
+        numThreads = hardware > 1 ? hardware - 1 : 0;
+    }
+    mThreads.reserve(numThreads);
+    for (unsigned int i = 0; i < numThreads; ++i)
+    {
+        mThreads.push_back(std::thread(&WorkerPool::WorkerLoop, this));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+    }
+    mWake.notify_all();
+    for (unsigned int i = 0, size = static_cast<unsigned>(mThreads.size()); i < size; ++i)
+    {
+        mThreads[i].join();
+    }
+}
+
+unsigned int WorkerPool::GetNumThreads() const
+{
+    return static_cast<unsigned>(mThreads.size());
+}
+
+void WorkerPool::WorkerLoop()
+{
+    unsigned int seenGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWake.wait(lock, [&]() { return mQuit || mGeneration != seenGeneration; });
+            if (mQuit)
+            {
+                return;
+            }
+            seenGeneration = mGeneration;
+            ++mActiveWorkers;
+        }
+
+        RunChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mActiveWorkers;
+        }
+        mDone.notify_all();
+    }
+}
+
+void WorkerPool::RunChunks()
+{
+    for (;;)
+    {
+        const unsigned int chunk = mNextChunk.fetch_add(1);
+        if (chunk >= mNumChunks)
+        {
+            return;
+        }
+        const unsigned int begin = chunk * mChunkSize;
+        const unsigned int end = mCount - begin < mChunkSize ? mCount : begin + mChunkSize;
+        mFunction(mContext, begin, end);
+    }
+}
+
+void WorkerPool::ParallelFor(unsigned int count, unsigned int chunkSize, ParallelForFunction function, void* context)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (chunkSize == 0)
+    {
+        chunkSize = 1;
+    }
+    const unsigned int numChunks = (count + chunkSize - 1) / chunkSize;
+    if (mThreads.empty() || numChunks == 1)
+    {
+        function(context, 0, count);
+        return;
+    }
+
+    {
+        // A worker waking late from the previous call can still be reading the old parameters,
+        // they are only rewritten once it has left. Workers registering after this block see
+        // the new ones through the mutex.
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [&]() { return mActiveWorkers == 0; });
+        mFunction = function;
+        mContext = context;
+        mCount = count;
+        mChunkSize = chunkSize;
+        mNumChunks = numChunks;
+        mNextChunk = 0;
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    RunChunks();
+
+    // Chunks are all handed out, wait for the workers still running theirs
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [&]() { return mActiveWorkers == 0; });
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Runs one [begin, end) range of a ParallelFor, context is whatever the caller passed in
+typedef void (*ParallelForFunction)(void* context, unsigned int begin, unsigned int end);
+
+// Fixed set of threads that sleep until ParallelFor hands them work. The calling thread
+// takes chunks too and returns once every chunk is done, so ranges can't outlive the call.
+// Chunks go to whichever thread is free, callers that need a deterministic result must not
+// let one chunk's output depend on another's.
+class WorkerPool
+{
+protected:
+    std::vector<std::thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    unsigned int mGeneration;
+    unsigned int mActiveWorkers;
+    bool mQuit;
+
+    ParallelForFunction mFunction;
+    void* mContext;
+    unsigned int mCount;
+    unsigned int mChunkSize;
+    unsigned int mNumChunks;
+    std::atomic<unsigned int> mNextChunk;
+
+    void WorkerLoop();
+    void RunChunks();
+private:
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+public:
+    // 0 threads uses one per hardware thread, minus the caller's
+    WorkerPool(unsigned int numThreads = 0);
+    ~WorkerPool();
+
+    unsigned int GetNumThreads() const;
+    void ParallelFor(unsigned int count, unsigned int chunkSize, ParallelForFunction function, void* context);
+};
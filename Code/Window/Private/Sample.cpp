@@ -2,62 +2,335 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "Window/Public/Sample.h"
 #include "GLTF/Public/GLTFLoader.h"
+#include "Animation/Public/KeyReduction.h"
 #include "OpenGL/Public/Uniform.h"
 #include "Window/Public/glad.h"
+#include <iostream>
+#include <chrono>
+#include <utility>
+
+namespace SampleHelpers
+{
+    // paletteName is the shader's per joint skinning array
+    SkinnedShaderSlots GetSkinnedSlots(Shader* shader, const char* paletteName)
+    {
+        SkinnedShaderSlots slots;
+        slots.mModel = shader->GetUniform("model");
+        slots.mView = shader->GetUniform("view");
+        slots.mProjection = shader->GetUniform("projection");
+        slots.mLight = shader->GetUniform("light");
+        slots.mSkin = shader->GetUniform(paletteName);
+        slots.mTex0 = shader->GetUniform("tex0");
+        slots.mPosition = shader->GetAttribute("position");
+        slots.mNormal = shader->GetAttribute("normal");
+        slots.mTexCoord = shader->GetAttribute("texCoord");
+        slots.mWeights = shader->GetAttribute("weights");
+        slots.mJoints = shader->GetAttribute("joints");
+        return slots;
+    }
+
+    // The static shader draws already skinned vertices, it has no palette or skin attributes
+    SkinnedShaderSlots GetStaticSlots(Shader* shader)
+    {
+        SkinnedShaderSlots slots;
+        slots.mModel = shader->GetUniform("model");
+        slots.mView = shader->GetUniform("view");
+        slots.mProjection = shader->GetUniform("projection");
+        slots.mLight = shader->GetUniform("light");
+        slots.mSkin = 0;
+        slots.mTex0 = shader->GetUniform("tex0");
+        slots.mPosition = shader->GetAttribute("position");
+        slots.mNormal = shader->GetAttribute("normal");
+        slots.mTexCoord = shader->GetAttribute("texCoord");
+        slots.mWeights = -1;
+        slots.mJoints = -1;
+        return slots;
+    }
+
+    // Parsing the glTF file and decoding its texture are independent, they run as two pool tasks
+    struct AssetFiles
+    {
+        const char* mModelPath;
+        const char* mTexturePath;
+        cgltf_data* mModel;
+        TextureImage* mTexture;
+    };
+
+    void LoadAssetFiles(void* context, unsigned int begin, unsigned int end)
+    {
+        AssetFiles* files = static_cast<AssetFiles*>(context);
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            if (i == 0)
+            {
+                // No model path when it comes from a cooked asset
+                if (files->mModelPath != nullptr)
+                {
+                    files->mModel = LoadGLTFFile(files->mModelPath);
+                }
+            }
+            else
+            {
+                files->mTexture->Decode(files->mTexturePath);
+            }
+        }
+    }
+} // End of SampleHelpers
 
 void Sample::Initialize()
 {
-    cgltf_data* gltf = LoadGLTFFile("Assets/Woman.gltf");
-    mCPUMeshes = LoadMeshes(gltf);
-    mSkeleton = LoadSkeleton(gltf);
-    mClips = LoadAnimationClips(gltf);
-    FreeGLTFFile(gltf);
+    // CPU work runs on the pool, every GL call stays on this thread, which owns the context
+    mWorkerPool = new WorkerPool();
+    const std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+
+    // A cooked asset from an earlier start skips the glTF parse, the import and the key reduction
+    const KeyReductionSettings reductionSettings;
+    CookedAssetSource source;
+    const bool hasSource = GetCookedAssetSource(SAMPLE_SOURCE_ASSET, reductionSettings, source);
+    const bool cooked = hasSource && mCookedAsset.Load(SAMPLE_COOKED_ASSET, source);
+
+    TextureImage diffuseImage;
+    SampleHelpers::AssetFiles files;
+    files.mModelPath = cooked ? nullptr : SAMPLE_SOURCE_ASSET;
+    files.mTexturePath = "Assets/Woman.png";
+    files.mModel = nullptr;
+    files.mTexture = &diffuseImage;
+    mWorkerPool->ParallelFor(2, 1, SampleHelpers::LoadAssetFiles, &files);
+
+    GLTFImporter importer;
+    if (cooked)
+    {
+        mSkeleton = mCookedAsset.GetSkeleton();
+        mCPUMeshes.swap(mCookedAsset.GetMeshes());
+        // Swapping the vectors keeps the clips sampling from the mapping, a copy would own its keys
+        mClips.swap(mCookedAsset.GetClips());
+    }
+    else
+    {
+        importer.Import(files.mModel, *mWorkerPool);
+        FreeGLTFFile(files.mModel);
+        mCPUMeshes = std::move(importer.GetMeshes());
+        mSkeleton = importer.GetSkeleton();
+    }
 
+    // Only the GPU skinned copies draw the bind pose streams, CPU meshes upload their skinned
+    // positions and normals every frame
+    const std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
     mGPUMeshes = mCPUMeshes;
     for (unsigned int i = 0, size = static_cast<unsigned>(mGPUMeshes.size()); i < size; ++i)
     {
         mGPUMeshes[i].UpdateOpenGLBuffers();
     }
+    mDiffuseTexture = new Texture();
+    mDiffuseTexture->Load(diffuseImage);
+    diffuseImage.Free();
+
+    const std::chrono::steady_clock::time_point loadEnd = std::chrono::steady_clock::now();
+    const std::chrono::duration<float, std::milli> loadTime = loadEnd - loadStart;
+    const std::chrono::duration<float, std::milli> uploadTime = loadEnd - uploadStart;
+    if (cooked)
+    {
+        std::cout << "Loaded " << SAMPLE_COOKED_ASSET << " and Assets/Woman.png in " << loadTime.count()
+            << " ms, upload " << uploadTime.count() << "\n";
+    }
+    else
+    {
+        const GLTFImportStats& importStats = importer.GetStats();
+        std::cout << "Loaded Assets/Woman.gltf and Assets/Woman.png in " << loadTime.count() << " ms. Import "
+            << importStats.mTotal << " ms: nodes " << importStats.mNodes << ", skeleton " << importStats.mSkeleton
+            << ", decode " << importStats.mDecode << " (meshes " << importStats.mMeshes << ", clips "
+            << importStats.mClips << "), upload " << uploadTime.count() << "\n";
+        const ConstantTrackStats& constantTracks = importer.GetConstantTrackStats();
+        std::cout << "Collapsed " << constantTracks.mCollapsed << " constant tracks, removed "
+            << constantTracks.mRemoved << " rest pose tracks, " << constantTracks.mJointsRemoved
+            << " joints no longer animated\n";
+
+        std::vector<Clip>& clips = importer.GetClips();
+        unsigned int numClips = static_cast<unsigned>(clips.size());
+        mClips.resize(numClips);
+        KeyReductionStats reduction;
+        CompressionStats compression;
+        TrackCompressionError worstTrack = {};
+        unsigned int worstClip = 0;
+        for (unsigned int i = 0; i < numClips; ++i)
+        {
+            KeyReductionStats clipReduction = ReduceClip(clips[i], mSkeleton, reductionSettings);
+            reduction.mKeysBefore += clipReduction.mKeysBefore;
+            reduction.mKeysAfter += clipReduction.mKeysAfter;
+            if (clipReduction.mMaxPositionError > reduction.mMaxPositionError)
+            {
+                reduction.mMaxPositionError = clipReduction.mMaxPositionError;
+            }
+            if (clipReduction.mMaxAngleError > reduction.mMaxAngleError)
+            {
+                reduction.mMaxAngleError = clipReduction.mMaxAngleError;
+            }
+            if (clipReduction.mMaxScaleError > reduction.mMaxScaleError)
+            {
+                reduction.mMaxScaleError = clipReduction.mMaxScaleError;
+            }
+            mClips[i] = PackClip(clips[i]);
+
+            // Playback keeps the full precision keys, this only reports what quantizing them would cost
+            CompressionStats clipCompression;
+            CompressClip(clips[i], &clipCompression);
+            compression.mOriginalBytes += clipCompression.mOriginalBytes;
+            compression.mCompressedBytes += clipCompression.mCompressedBytes;
+            for (const TrackCompressionError& trackError : clipCompression.mTracks)
+            {
+                if (trackError.mRotationError > worstTrack.mRotationError)
+                {
+                    worstTrack = trackError;
+                    worstClip = i;
+                }
+            }
+        }
+        std::cout << "Reduced " << numClips << " clips from " << reduction.mKeysBefore << " to "
+            << reduction.mKeysAfter << " keys, max position error " << reduction.mMaxPositionError
+            << ", max rotation error " << reduction.mMaxAngleError << " degrees, max scale error "
+            << reduction.mMaxScaleError << "\n";
+        std::cout << "Compressing them would take " << compression.mCompressedBytes << " of "
+            << compression.mOriginalBytes << " bytes";
+        if (worstTrack.mRotationError > 0.0f)
+        {
+            std::cout << ", worst track " << mSkeleton.GetJointName(worstTrack.mJoint) << " in "
+                << clips[worstClip].GetName() << " with " << worstTrack.mRotationError
+                << " degrees rotation error, " << worstTrack.mPositionError << " position error and "
+                << worstTrack.mScaleError << " scale error";
+        }
+        std::cout << "\n";
+
+        // Cooked from the bind pose meshes and the reduced clips, before anything is skinned
+        if (hasSource && CookAsset(SAMPLE_COOKED_ASSET, source, mSkeleton, mCPUMeshes, clips))
+        {
+            std::cout << "Cooked " << SAMPLE_COOKED_ASSET << " for the next start\n";
+        }
+    }
+
+    // The tables are rebuilt on every start, the cooked file only holds the keys
+    for (unsigned int i = 0, size = static_cast<unsigned>(mClips.size()); i < size; ++i)
+    {
+        mClips[i].UpdateIndexLookupTables(SAMPLE_LOOKUP_RATE);
+    }
 
     mStaticShader = new Shader("Shaders/static.vert", "Shaders/lit.frag");
-    mSkinnedShader = new Shader("Shaders/skinned.vert", "Shaders/lit.frag");
-    mDiffuseTexture = new Texture("Assets/Woman.png");
+    mSkinnedShader = new Shader("Shaders/skinned_affine.vert", "Shaders/lit.frag");
+    mDualQuatShader = new Shader("Shaders/skinned_dq.vert", "Shaders/lit.frag");
+    mStaticSlots = SampleHelpers::GetStaticSlots(mStaticShader);
+    mSkinnedSlots = SampleHelpers::GetSkinnedSlots(mSkinnedShader, "skin");
+    mDualQuatSlots = SampleHelpers::GetSkinnedSlots(mDualQuatShader, "dq");
+    mSkinningMode = SkinningMode::LinearBlend;
+    std::cout << "Press " << static_cast<char>(SAMPLE_SKINNING_MODE_KEY)
+        << " to switch between linear blend and dual quaternion skinning\n";
+
+    mGPUAnimInfo.mSkinPalettes.resize(mGPUMeshes.size());
+    mGPUAnimInfo.mAffinePalettes.resize(mGPUMeshes.size());
+    mGPUAnimInfo.mDualQuatPalettes.resize(mGPUMeshes.size());
+    mCPUAnimInfo.mSkinPalettes.resize(mCPUMeshes.size());
+    mCPUAnimInfo.mDualQuatPalettes.resize(mCPUMeshes.size());
 
-    mGPUAnimInfo.mAnimatedPose = mSkeleton.GetRestPose();
-    mGPUAnimInfo.mPosePalette.resize(mSkeleton.GetRestPose().Size());
-    mCPUAnimInfo.mAnimatedPose = mSkeleton.GetRestPose();
-    mCPUAnimInfo.mPosePalette.resize(mSkeleton.GetRestPose().Size());
+    unsigned int numFallback = 0;
+    mCPUFallback.resize(mGPUMeshes.size());
+    for (unsigned int i = 0, size = static_cast<unsigned>(mGPUMeshes.size()); i < size; ++i)
+    {
+        mCPUFallback[i] = mGPUMeshes[i].GetSkinJoints().size() > SAMPLE_MAX_GPU_JOINTS;
+        if (mCPUFallback[i])
+        {
+            std::cout << "WARNING: mesh " << i << " has more skin joints than the skinning shaders hold, "
+                "it is skinned on the CPU\n";
+            ++numFallback;
+        }
+    }
+    mSkinJobs.reserve(mCPUMeshes.size() + numFallback);
 
     mGPUAnimInfo.mModel.position = Vec3(-2, 0, 0);
     mCPUAnimInfo.mModel.position = Vec3(2, 0, 0);
 
+    unsigned int cpuClip = 0;
+    unsigned int gpuClip = 0;
     unsigned int numUIClips = static_cast<unsigned>(mClips.size());
     for (unsigned int i = 0; i < numUIClips; ++i)
     {
         if (mClips[i].GetName() == "Walking")
         {
-            mCPUAnimInfo.mClip = i;
+            cpuClip = i;
         }
         else if (mClips[i].GetName() == "Running")
         {
-            mGPUAnimInfo.mClip = i;
+            gpuClip = i;
         }
     }
+    PlayClip(mCPUAnimInfo, cpuClip);
+    PlayClip(mGPUAnimInfo, gpuClip);
+}
+
+// Clips only write the joints they animate, starting from the rest pose means nothing the
+// previous clip wrote is left behind on the joints this one doesn't animate
+void Sample::PlayClip(AnimationInstance& instance, unsigned int clip)
+{
+    instance.mClip = clip;
+    instance.mPlayback = 0.0f;
+    instance.mCursor = PackedClipCursor();
+    instance.mAnimatedPose = mSkeleton.GetRestPose();
 }
 
 void Sample::Update(float deltaTime)
 {
     mCPUAnimInfo.mPlayback = mClips[mCPUAnimInfo.mClip].Sample(mCPUAnimInfo.mAnimatedPose,
-                                                               mCPUAnimInfo.mPlayback + deltaTime);
+                                                               mCPUAnimInfo.mPlayback + deltaTime,
+                                                               mCPUAnimInfo.mCursor);
     mGPUAnimInfo.mPlayback = mClips[mGPUAnimInfo.mClip].Sample(mGPUAnimInfo.mAnimatedPose,
-                                                               mGPUAnimInfo.mPlayback + deltaTime);
+                                                               mGPUAnimInfo.mPlayback + deltaTime,
+                                                               mGPUAnimInfo.mCursor);
 
-    for (unsigned int i = 0, size = static_cast<unsigned>(mCPUMeshes.size()); i < size; ++i)
+    unsigned int numCPUMeshes = static_cast<unsigned>(mCPUMeshes.size());
+    unsigned int numGPUMeshes = static_cast<unsigned>(mGPUMeshes.size());
+    if (mSkinningMode == SkinningMode::DualQuaternion)
     {
-        mCPUMeshes[i].CPUSkin(mSkeleton, mCPUAnimInfo.mAnimatedPose);
+        for (unsigned int i = 0; i < numCPUMeshes; ++i)
+        {
+            std::vector<DualQuat>& palette = mCPUAnimInfo.mDualQuatPalettes[i];
+            mSkeleton.GetDualQuatSkinPalette(mCPUAnimInfo.mAnimatedPose, mCPUMeshes[i].GetSkinJoints(), palette);
+            mCPUMeshes[i].CPUSkin(palette, *mWorkerPool);
+        }
+        for (unsigned int i = 0; i < numGPUMeshes; ++i)
+        {
+            std::vector<DualQuat>& palette = mGPUAnimInfo.mDualQuatPalettes[i];
+            mSkeleton.GetDualQuatSkinPalette(mGPUAnimInfo.mAnimatedPose, mGPUMeshes[i].GetSkinJoints(), palette);
+            if (mCPUFallback[i])
+            {
+                mGPUMeshes[i].CPUSkin(palette, *mWorkerPool);
+            }
+        }
+        return;
     }
 
-    mGPUAnimInfo.mAnimatedPose.GetMatrixPalette(mGPUAnimInfo.mPosePalette);
+    mSkinJobs.clear();
+    for (unsigned int i = 0; i < numCPUMeshes; ++i)
+    {
+        std::vector<Mat4>& palette = mCPUAnimInfo.mSkinPalettes[i];
+        mSkeleton.GetSkinPalette(mCPUAnimInfo.mAnimatedPose, mCPUMeshes[i].GetSkinJoints(), palette);
+        SkinJob job;
+        job.mMesh = &mCPUMeshes[i];
+        job.mSkinPalette = &palette;
+        mSkinJobs.push_back(job);
+    }
+    for (unsigned int i = 0; i < numGPUMeshes; ++i)
+    {
+        if (!mCPUFallback[i])
+        {
+            mSkeleton.GetAffineSkinPalette(mGPUAnimInfo.mAnimatedPose, mGPUMeshes[i].GetSkinJoints(),
+                                           mGPUAnimInfo.mAffinePalettes[i]);
+            continue;
+        }
+        std::vector<Mat4>& palette = mGPUAnimInfo.mSkinPalettes[i];
+        mSkeleton.GetSkinPalette(mGPUAnimInfo.mAnimatedPose, mGPUMeshes[i].GetSkinJoints(), palette);
+        SkinJob job;
+        job.mMesh = &mGPUMeshes[i];
+        job.mSkinPalette = &palette;
+        mSkinJobs.push_back(job);
+    }
+    Mesh::CPUSkinBatch(mSkinJobs.data(), static_cast<unsigned>(mSkinJobs.size()), *mWorkerPool);
 }
 
 void Sample::Render(float inAspectRatio)
@@ -89,29 +362,84 @@ void Sample::Render(float inAspectRatio)
     */
     
     // GPU Skinned Mesh
+    const bool dualQuat = mSkinningMode == SkinningMode::DualQuaternion;
+    Shader* shader = dualQuat ? mDualQuatShader : mSkinnedShader;
+    const SkinnedShaderSlots& slots = dualQuat ? mDualQuatSlots : mSkinnedSlots;
     model = (mGPUAnimInfo.mModel).ToMat4();
-    mSkinnedShader->Bind();
-    Uniform<Mat4>::Set(mSkinnedShader->GetUniform("model"), model);
-    Uniform<Mat4>::Set(mSkinnedShader->GetUniform("view"), view);
-    Uniform<Mat4>::Set(mSkinnedShader->GetUniform("projection"), projection);
-    Uniform<Vec3>::Set(mSkinnedShader->GetUniform("light"), Vec3(-5, 5, 1));
+    shader->Bind();
+    Uniform<Mat4>::Set(slots.mModel, model);
+    Uniform<Mat4>::Set(slots.mView, view);
+    Uniform<Mat4>::Set(slots.mProjection, projection);
+    Uniform<Vec3>::Set(slots.mLight, Vec3(-5, 5, 1));
 
-    Uniform<Mat4>::Set(mSkinnedShader->GetUniform("pose"), mGPUAnimInfo.mPosePalette);
-    Uniform<Mat4>::Set(mSkinnedShader->GetUniform("invBindPose"), mSkeleton.GetInvBindPose());
+    mDiffuseTexture->Set(slots.mTex0, 0);
+    bool anyFallback = false;
+    for (unsigned int i = 0, size = static_cast<unsigned>(mGPUMeshes.size()); i < size; ++i)
+    {
+        if (mCPUFallback[i])
+        {
+            anyFallback = true;
+            continue;
+        }
+        // Each mesh uploads only its skin's joints, 8 floats a joint for dual quaternions,
+        // 12 for affine matrices
+        if (dualQuat)
+        {
+            Uniform<DualQuat>::Set(slots.mSkin, mGPUAnimInfo.mDualQuatPalettes[i]);
+        }
+        else
+        {
+            Uniform<Mat3x4>::Set(slots.mSkin, mGPUAnimInfo.mAffinePalettes[i]);
+        }
+        mGPUMeshes[i].Bind(slots.mPosition, slots.mNormal, slots.mTexCoord, slots.mWeights, slots.mJoints);
+        mGPUMeshes[i].Draw();
+        mGPUMeshes[i].UnBind(slots.mPosition, slots.mNormal, slots.mTexCoord, slots.mWeights, slots.mJoints);
+    }
+    mDiffuseTexture->UnSet(0);
+    shader->UnBind();
 
-    mDiffuseTexture->Set(mSkinnedShader->GetUniform("tex0"), 0);
+    if (!anyFallback)
+    {
+        return;
+    }
+    // Skins too large for the shaders were skinned on the CPU in Update
+    mStaticShader->Bind();
+    Uniform<Mat4>::Set(mStaticSlots.mModel, model);
+    Uniform<Mat4>::Set(mStaticSlots.mView, view);
+    Uniform<Mat4>::Set(mStaticSlots.mProjection, projection);
+    Uniform<Vec3>::Set(mStaticSlots.mLight, Vec3(-5, 5, 1));
+    mDiffuseTexture->Set(mStaticSlots.mTex0, 0);
     for (unsigned int i = 0, size = static_cast<unsigned>(mGPUMeshes.size()); i < size; ++i)
     {
-        mGPUMeshes[i].Bind(mSkinnedShader->GetAttribute("position"), mSkinnedShader->GetAttribute("normal"),
-                           mSkinnedShader->GetAttribute("texCoord"), mSkinnedShader->GetAttribute("weights"),
-                           mSkinnedShader->GetAttribute("joints"));
+        if (!mCPUFallback[i])
+        {
+            continue;
+        }
+        mGPUMeshes[i].Bind(mStaticSlots.mPosition, mStaticSlots.mNormal, mStaticSlots.mTexCoord, -1, -1);
         mGPUMeshes[i].Draw();
-        mGPUMeshes[i].UnBind(mSkinnedShader->GetAttribute("position"), mSkinnedShader->GetAttribute("normal"),
-                             mSkinnedShader->GetAttribute("texCoord"), mSkinnedShader->GetAttribute("weights"),
-                             mSkinnedShader->GetAttribute("joints"));
+        mGPUMeshes[i].UnBind(mStaticSlots.mPosition, mStaticSlots.mNormal, mStaticSlots.mTexCoord, -1, -1);
     }
     mDiffuseTexture->UnSet(0);
-    mSkinnedShader->UnBind();
+    mStaticShader->UnBind();
+}
+
+void Sample::OnKeyDown(unsigned int inKey)
+{
+    if (inKey != SAMPLE_SKINNING_MODE_KEY)
+    {
+        return;
+    }
+    // Update builds the palettes of the new mode before the next Render
+    if (mSkinningMode == SkinningMode::LinearBlend)
+    {
+        mSkinningMode = SkinningMode::DualQuaternion;
+        std::cout << "Dual quaternion skinning\n";
+    }
+    else
+    {
+        mSkinningMode = SkinningMode::LinearBlend;
+        std::cout << "Linear blend skinning\n";
+    }
 }
 
 void Sample::Shutdown()
@@ -119,7 +447,11 @@ void Sample::Shutdown()
     delete mStaticShader;
     delete mDiffuseTexture;
     delete mSkinnedShader;
+    delete mDualQuatShader;
+    delete mWorkerPool;
+    // Cooked clips sample from the asset's mapping, they go first
     mClips.clear();
+    mCookedAsset.Unload();
     mCPUMeshes.clear();
     mGPUMeshes.clear();
 }
@@ -10,6 +10,7 @@
 #include <iostream>
 #include "Window/Public/glad.h"
 #include "Window/Public/Sample.h"
+#include "Memory/Public/AllocationTracker.h"
 
 int WINAPI WinMain(HINSTANCE, HINSTANCE, PSTR, int);
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
@@ -147,6 +148,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
     gApplication->Initialize();
 
     DWORD lastTick = GetTickCount();
+#if ALLOCATION_TRACKER
+    unsigned int frameNumber = 0;
+#endif
     MSG msg;
     while (true)
     {
@@ -162,6 +166,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
         DWORD thisTick = GetTickCount();
         float deltaTime = static_cast<float>(thisTick - lastTick) * 0.001f;
         lastTick = thisTick;
+#if ALLOCATION_TRACKER
+        BeginAllocationFrame();
+#endif
         if (gApplication != nullptr)
         {
             gApplication->Update(deltaTime);
@@ -184,6 +191,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR szCmdLine,
             float aspect = static_cast<float>(clientWidth) / static_cast<float>(clientHeight);
             gApplication->Render(aspect);
         }
+#if ALLOCATION_TRACKER
+        AllocationStats frameAllocations = EndAllocationFrame();
+        if (++frameNumber > ALLOCATION_TRACKER_WARMUP_FRAMES)
+        {
+            ExpectNoFrameAllocations(frameAllocations, "Frame allocated");
+        }
+#endif
         if (gApplication != nullptr)
         {
             SwapBuffers(hdc);
@@ -240,6 +254,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
             std::cout << "Got multiple destroy messages\n";
         }
         break;
+    case WM_KEYDOWN:
+        // Bit 30 is set when the key was already down
+        if (gApplication != nullptr && (lParam & (1 << 30)) == 0)
+        {
+            gApplication->OnKeyDown(static_cast<unsigned int>(wParam));
+        }
+        break;
     case WM_PAINT:
     case WM_ERASEBKGND:
         return 0;
@@ -11,5 +11,7 @@ public:
 	virtual void Initialize() { }
 	virtual void Update(float inDeltaTime) { }
 	virtual void Render(float inAspectRatio) { }
+	// Virtual key code of a key that was just pressed, auto repeats are filtered out
+	virtual void OnKeyDown(unsigned int inKey) { }
 	virtual void Shutdown() { }
 };
\ No newline at end of file
@@ -4,16 +4,37 @@
 #include <vector>
 #include "Animation/Public/Pose.h"
 #include "Animation/Public/Clip.h"
+#include "Animation/Public/PackedClip.h"
 #include "Animation/Public/Skeleton.h"
+#include "Asset/Public/CookedAsset.h"
 #include "Rendering/Public/Mesh.h"
 #include "OpenGL/Public/Texture.h"
 #include "OpenGL/Public/Shader.h"
+#include "Threading/Public/WorkerPool.h"
 #include <vector>
 
+// Written from the glTF file on the first start, loaded instead of it on the next ones until
+// the glTF file or the key reduction settings change
+#define SAMPLE_SOURCE_ASSET "Assets/Woman.gltf"
+#define SAMPLE_COOKED_ASSET "Assets/Woman.cooked"
+
+// Buckets per second of every clip's frame lookup tables, one per frame at 60 fps
+#define SAMPLE_LOOKUP_RATE 60.0f
+
+// Key that switches between linear blend and dual quaternion skinning
+#define SAMPLE_SKINNING_MODE_KEY 'D'
+
+// Joints per skin the GPU skinning shaders hold, skinned_dq.vert has the smaller array
+#define SAMPLE_MAX_GPU_JOINTS 120
+
 struct AnimationInstance
 {
     Pose mAnimatedPose;
-    std::vector<Mat4> mPosePalette;
+    // One palette per mesh, holding only the joints of that mesh's skin
+    std::vector<std::vector<Mat4>> mSkinPalettes;
+    std::vector<std::vector<Mat3x4>> mAffinePalettes;
+    std::vector<std::vector<DualQuat>> mDualQuatPalettes;
+    PackedClipCursor mCursor;
     unsigned int mClip;
     float mPlayback;
     Transform mModel;
@@ -23,22 +44,60 @@ struct AnimationInstance
     }
 };
 
+enum class SkinningMode
+{
+    LinearBlend,
+    DualQuaternion
+};
+
+// Shader slots looked up once at load, every name lookup builds a std::string
+struct SkinnedShaderSlots
+{
+    unsigned int mModel;
+    unsigned int mView;
+    unsigned int mProjection;
+    unsigned int mLight;
+    unsigned int mSkin;
+    unsigned int mTex0;
+    int mPosition;
+    int mNormal;
+    int mTexCoord;
+    int mWeights;
+    int mJoints;
+};
+
 class Sample : public Application
 {
 protected:
     Texture* mDiffuseTexture;
     Shader* mStaticShader;
     Shader* mSkinnedShader;
+    Shader* mDualQuatShader;
+    SkinnedShaderSlots mStaticSlots;
+    SkinnedShaderSlots mSkinnedSlots;
+    SkinnedShaderSlots mDualQuatSlots;
+    SkinningMode mSkinningMode;
+    WorkerPool* mWorkerPool;
     std::vector<Mesh> mCPUMeshes;
     std::vector<Mesh> mGPUMeshes;
+    // Per GPU mesh, true when its skin has more joints than the shaders hold. Those meshes are
+    // skinned on the CPU with the GPU instance's pose and drawn with the static shader.
+    std::vector<bool> mCPUFallback;
+    std::vector<SkinJob> mSkinJobs;
     Skeleton mSkeleton;
-    std::vector<Clip> mClips;
+    // Holds the mapping cooked clips sample from, declared before mClips so it outlives them
+    CookedAsset mCookedAsset;
+    // Reduced clips packed for playback, key times shared and tangents only on cubic tracks
+    std::vector<PackedClip> mClips;
 
     AnimationInstance mGPUAnimInfo;
     AnimationInstance mCPUAnimInfo;
+
+    void PlayClip(AnimationInstance& instance, unsigned int clip);
 public:
     void Initialize() override;
     void Update(float deltaTime) override;
     void Render(float inAspectRatio) override;
+    void OnKeyDown(unsigned int inKey) override;
     void Shutdown() override;
 };
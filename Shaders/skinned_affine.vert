@@ -0,0 +1,35 @@
+#version 330 core
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+in vec4 weights;
+in ivec4 joints;
+
+// Skin matrix rows, three vec4 per joint. The same budget as mat4 skin[120] holds 160 joints.
+uniform vec4 skin[480];
+
+out vec3 norm;
+out vec3 fragPos;
+out vec2 uv;
+
+void main() {
+    ivec4 base = joints * 3;
+    vec4 row0 = skin[base.x] * weights.x + skin[base.y] * weights.y + skin[base.z] * weights.z + skin[base.w] * weights.w;
+    vec4 row1 = skin[base.x + 1] * weights.x + skin[base.y + 1] * weights.y + skin[base.z + 1] * weights.z + skin[base.w + 1] * weights.w;
+    vec4 row2 = skin[base.x + 2] * weights.x + skin[base.y + 2] * weights.y + skin[base.z + 2] * weights.z + skin[base.w + 2] * weights.w;
+
+    vec4 p = vec4(position, 1.0);
+    vec4 n = vec4(normal, 0.0);
+    vec4 skinned = vec4(dot(row0, p), dot(row1, p), dot(row2, p), 1.0);
+
+    gl_Position = projection * view * model * skinned;
+    
+    fragPos = vec3(model * skinned);
+    norm = vec3(model * vec4(dot(row0, n), dot(row1, n), dot(row2, n), 0.0f));
+    uv = texCoord;
+}
@@ -0,0 +1,50 @@
+#version 330 core
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+in vec4 weights;
+in ivec4 joints;
+
+// Dual quaternion skin transform per joint, column 0 is the real part and column 1 the dual part
+uniform mat2x4 dq[120];
+
+out vec3 norm;
+out vec3 fragPos;
+out vec2 uv;
+
+vec3 rotate(vec4 q, vec3 v) {
+    return q.xyz * 2.0 * dot(q.xyz, v) +
+        v * (q.w * q.w - dot(q.xyz, q.xyz)) +
+        cross(q.xyz, v) * 2.0 * q.w;
+}
+
+void main() {
+    mat2x4 dq0 = dq[joints.x];
+    mat2x4 dq1 = dq[joints.y];
+    mat2x4 dq2 = dq[joints.z];
+    mat2x4 dq3 = dq[joints.w];
+
+    // Keep every influence in the first one's hemisphere
+    float w1 = dot(dq0[0], dq1[0]) < 0.0 ? -weights.y : weights.y;
+    float w2 = dot(dq0[0], dq2[0]) < 0.0 ? -weights.z : weights.z;
+    float w3 = dot(dq0[0], dq3[0]) < 0.0 ? -weights.w : weights.w;
+
+    mat2x4 blended = dq0 * weights.x + dq1 * w1 + dq2 * w2 + dq3 * w3;
+    float invLen = 1.0 / length(blended[0]);
+    vec4 real = blended[0] * invLen;
+    vec4 dual = blended[1] * invLen;
+
+    vec3 translation = (dual.xyz * real.w - real.xyz * dual.w + cross(real.xyz, dual.xyz)) * 2.0;
+    vec4 skinned = vec4(rotate(real, position) + translation, 1.0);
+
+    gl_Position = projection * view * model * skinned;
+    
+    fragPos = vec3(model * skinned);
+    norm = vec3(model * vec4(rotate(real, normal), 0.0f));
+    uv = texCoord;
+}